@@ -0,0 +1,414 @@
+#pragma once
+
+#include "thread_pool/task_group.h"
+#include "thread_pool/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tp {
+
+/// How a parallel algorithm splits its range into tasks
+enum class Partitioner {
+    /// One equal chunk per worker, cheapest when every element costs the same
+    kStatic,
+    /// Workers repeatedly claim fixed size chunks from a shared counter
+    kDynamic,
+    /// Like dynamic, but chunks start large and shrink as the range runs out
+    kGuided,
+    /// Lazy binary splitting, a range is halved only while the pool is hungry for work
+    kAuto,
+};
+
+/// Parameters of a parallel algorithm
+struct ParallelParams {
+    Partitioner partitioner = Partitioner::kAuto;
+    /// Smallest chunk handed to one task, 0 picks one from the range size
+    size_t grain = 0;
+};
+
+namespace details {
+
+/// Size of a cache line, partials written by different workers live on separate lines
+constexpr size_t kCacheLineSize = 64;
+
+/// Number of chunks per participating thread when picking a grain automatically
+constexpr size_t kChunksPerThread = 16;
+
+/// Grain to use for a range of n elements split across threads
+inline size_t grain_for(const ParallelParams &params, const size_t n, const size_t threads) noexcept {
+    if (params.grain > 0) {
+        return params.grain;
+    }
+    return std::max<size_t>(n / (threads * kChunksPerThread), 1);
+}
+
+/// Length of [begin, end), end must not be before begin
+/// Computed in the unsigned type so a signed range wider than the type's max does not overflow
+template <typename Index>
+size_t distance(const Index begin, const Index end) noexcept {
+    using Unsigned = std::make_unsigned_t<Index>;
+    return static_cast<Unsigned>(static_cast<Unsigned>(end) - static_cast<Unsigned>(begin));
+}
+
+/// Index offset from begin, wraps through the unsigned type for the same reason
+template <typename Index>
+Index advance(const Index begin, const size_t offset) noexcept {
+    using Unsigned = std::make_unsigned_t<Index>;
+    return static_cast<Index>(static_cast<Unsigned>(static_cast<Unsigned>(begin) + static_cast<Unsigned>(offset)));
+}
+
+/// One equal chunk per thread, chunk 0 runs on the calling thread
+/// Chunks are passed to chunk(first, last) as offsets into the range
+template <typename Chunk>
+void for_static(thread_pool &pool, const size_t n, const size_t grain, const size_t threads, Chunk &chunk) {
+    const auto chunks = std::min(threads, (n + grain - 1) / grain);
+    auto run_chunk = [&chunk, n, chunks](const size_t index) {
+        chunk(n * index / chunks, n * (index + 1) / chunks);
+    };
+
+    // Declared last so it finishes waiting before anything its tasks reference goes away, even when chunk throws
+    task_group group(pool);
+    for (size_t index = 1; index < chunks; index++) {
+        group.spawn(run_chunk, index);
+    }
+    run_chunk(0);
+    group.wait();
+}
+
+/// Every thread claims chunks from a shared counter until the range runs out
+/// Guided chunks are a share of what remains but never less than the grain
+template <typename Chunk>
+void for_claimed(thread_pool &pool, const size_t n, const size_t grain, const size_t threads, const bool guided,
+                 Chunk &chunk) {
+    std::atomic<size_t> next{0};
+
+    auto claim = [&next, n, grain, threads, guided](size_t &first, size_t &last) {
+        if (!guided) {
+            first = next.fetch_add(grain, std::memory_order_relaxed);
+            last = std::min(first + grain, n);
+            return first < n;
+        }
+
+        first = next.load(std::memory_order_relaxed);
+        while (first < n) {
+            const auto size = std::max((n - first) / (2 * threads), grain);
+            last = std::min(first + size, n);
+            if (next.compare_exchange_weak(first, last, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto run = [&chunk, &claim] {
+        size_t first = 0;
+        size_t last = 0;
+        while (claim(first, last)) {
+            chunk(first, last);
+        }
+    };
+
+    task_group group(pool);
+    const auto helpers = std::min(threads, (n + grain - 1) / grain) - 1;
+    for (size_t ii = 0; ii < helpers; ii++) {
+        group.spawn(run);
+    }
+    run();
+    group.wait();
+}
+
+/// Runs chunk over [first, last) with lazy binary splitting
+/// The right half is split off and spawned only while the pool has fewer queued tasks than workers
+template <typename Chunk>
+void split_lazily(thread_pool &pool, task_group &group, size_t first, size_t last, const size_t grain, Chunk &chunk) {
+    while (last - first > grain) {
+        if (pool.qsize() < pool.size()) {
+            const auto middle = first + (last - first + 1) / 2;
+            group.spawn([&pool, &group, middle, last, grain, &chunk] {
+                split_lazily(pool, group, middle, last, grain, chunk);
+            });
+            last = middle;
+            continue;
+        }
+
+        // Nobody is hungry, keep working through the range a grain at a time
+        chunk(first, first + grain);
+        first += grain;
+    }
+
+    chunk(first, last);
+}
+
+/// Lazy binary splitting from the whole range
+template <typename Chunk>
+void for_auto(thread_pool &pool, const size_t n, const size_t grain, Chunk &chunk) {
+    task_group group(pool);
+    split_lazily(pool, group, 0, n, grain, chunk);
+    group.wait();
+}
+
+/// Splits [0, n) into chunks according to params and runs them on the pool and the calling thread
+template <typename Chunk>
+void for_chunks(thread_pool &pool, const size_t n, const ParallelParams &params, Chunk &chunk) {
+    // Split for the largest the pool can get, so workers an elastic pool spawns meanwhile get a share
+    const auto threads = pool.max_size() + 1;
+    const auto grain = grain_for(params, n, threads);
+
+    switch (params.partitioner) {
+        case Partitioner::kStatic:
+            for_static(pool, n, grain, threads, chunk);
+            break;
+        case Partitioner::kDynamic:
+            for_claimed(pool, n, grain, threads, false, chunk);
+            break;
+        case Partitioner::kGuided:
+            for_claimed(pool, n, grain, threads, true, chunk);
+            break;
+        case Partitioner::kAuto:
+            for_auto(pool, n, grain, chunk);
+            break;
+    }
+}
+
+/// Ranges at most this long are sorted or merged sequentially
+constexpr size_t kSortCutoff = 4096;
+constexpr size_t kMergeCutoff = 8192;
+
+/// Fewest elements in a scan chunk, every element is read in both passes so a chunk has to be worth two tasks
+constexpr size_t kScanMinChunk = 4096;
+
+/// Merges [first1, last1) and [first2, last2) into out by moving, splitting large merges across the pool
+/// The middle of the longer range is located in the shorter one and both sides merge in parallel
+template <typename Input, typename Output, typename Compare>
+void merge_moving(thread_pool &pool, Input first1, Input last1, Input first2, Input last2, Output out, Compare &comp) {
+    const auto n1 = static_cast<size_t>(last1 - first1);
+    const auto n2 = static_cast<size_t>(last2 - first2);
+    if (n1 + n2 <= kMergeCutoff) {
+        std::merge(std::make_move_iterator(first1), std::make_move_iterator(last1), std::make_move_iterator(first2),
+                   std::make_move_iterator(last2), out, comp);
+        return;
+    }
+
+    Input middle1;
+    Input middle2;
+    if (n1 >= n2) {
+        middle1 = first1 + n1 / 2;
+        middle2 = std::lower_bound(first2, last2, *middle1, comp);
+    } else {
+        middle2 = first2 + n2 / 2;
+        middle1 = std::upper_bound(first1, last1, *middle2, comp);
+    }
+
+    const auto out_middle = out + ((middle1 - first1) + (middle2 - first2));
+    task_group group(pool);
+    group.spawn([&pool, first1, middle1, first2, middle2, out, &comp] {
+        merge_moving(pool, first1, middle1, first2, middle2, out, comp);
+    });
+    merge_moving(pool, middle1, last1, middle2, last2, out_middle, comp);
+    group.wait();
+}
+
+/// Sorts [first, first + n), leaving the result in the buffer if into_buffer, otherwise in place
+/// Each half is sorted into the other array so merging it back lands where the caller wants it
+template <typename Iterator, typename Buffer, typename Compare>
+void merge_sort(thread_pool &pool, const Iterator first, const Buffer buffer, const size_t n, const bool into_buffer,
+          Compare &comp) {
+    if (n <= kSortCutoff) {
+        std::sort(first, first + n, comp);
+        if (into_buffer) {
+            std::move(first, first + n, buffer);
+        }
+        return;
+    }
+
+    const auto half = n / 2;
+    {
+        task_group group(pool);
+        group.spawn([&pool, first, buffer, half, into_buffer, &comp] {
+            merge_sort(pool, first, buffer, half, !into_buffer, comp);
+        });
+        merge_sort(pool, first + half, buffer + half, n - half, !into_buffer, comp);
+        group.wait();
+    }
+
+    if (into_buffer) {
+        merge_moving(pool, first, first + half, first + half, first + n, buffer, comp);
+    } else {
+        merge_moving(pool, buffer, buffer + half, buffer + half, buffer + n, first, comp);
+    }
+}
+
+} // namespace details
+
+/// Calls fn(i) for every i in [begin, end) on the pool's workers and the calling thread
+/// Waiting helps the pool, so this may be called from inside a pool task
+/// Rethrows the first exception thrown by fn, once every chunk has finished
+template <typename Index, typename Function>
+void parallel_for(thread_pool &pool, const Index begin, const Index end, Function &&fn,
+                  const ParallelParams &params = {}) {
+    static_assert(std::is_integral_v<Index>, "Index must be an integer");
+    if (end <= begin) {
+        return;
+    }
+
+    auto chunk = [&fn, begin](const size_t first, const size_t last) {
+        for (auto ii = first; ii < last; ii++) {
+            fn(details::advance(begin, ii));
+        }
+    };
+    details::for_chunks(pool, details::distance(begin, end), params, chunk);
+}
+
+/// Combines map(i) for every i in [begin, end) starting from identity
+/// Each chunk folds into a local, which is folded into its worker's own partial, and the partials are combined
+/// pairwise at the end, so combine must be associative and commutative
+/// \returns the combined value, identity for an empty range
+template <typename Index, typename T, typename Map, typename Combine>
+T parallel_reduce(thread_pool &pool, const Index begin, const Index end, const T identity, Map &&map,
+                  Combine &&combine, const ParallelParams &params = {}) {
+    static_assert(std::is_integral_v<Index>, "Index must be an integer");
+    if (end <= begin) {
+        return identity;
+    }
+
+    // One partial per worker index on its own cache line, threads outside the pool share the last one under a lock
+    struct alignas(details::kCacheLineSize) Partial {
+        T value;
+    };
+    const auto workers = pool.max_size();
+    std::vector<Partial> partials(workers + 1, Partial{identity});
+    std::mutex outsider_lock;
+
+    auto chunk = [&](const size_t first, const size_t last) {
+        T local = identity;
+        for (auto ii = first; ii < last; ii++) {
+            local = combine(std::move(local), map(details::advance(begin, ii)));
+        }
+
+        const auto worker = pool.worker_index();
+        if (worker.has_value()) {
+            auto &partial = partials[worker.value()].value;
+            partial = combine(std::move(partial), std::move(local));
+        } else {
+            std::scoped_lock lock(outsider_lock);
+            auto &partial = partials[workers].value;
+            partial = combine(std::move(partial), std::move(local));
+        }
+    };
+    details::for_chunks(pool, details::distance(begin, end), params, chunk);
+
+    // Tree combine
+    for (size_t stride = 1; stride < partials.size(); stride *= 2) {
+        for (size_t ii = 0; ii + stride < partials.size(); ii += 2 * stride) {
+            partials[ii].value = combine(std::move(partials[ii].value), std::move(partials[ii + stride].value));
+        }
+    }
+
+    return std::move(partials[0].value);
+}
+
+/// Combines transform(*it) for every it in [first, last) starting from init, like std::transform_reduce
+/// \returns the combined value, init for an empty range
+template <typename Iterator, typename T, typename Combine, typename Transform>
+T parallel_transform_reduce(thread_pool &pool, const Iterator first, const Iterator last, const T init,
+                            Combine &&combine, Transform &&transform, const ParallelParams &params = {}) {
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<Iterator>::iterator_category>,
+                  "Iterator must be random access");
+
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    return parallel_reduce(pool, size_t{0}, n, init,
+                           [&transform, first](const size_t ii) { return transform(first[ii]); },
+                           std::forward<Combine>(combine), params);
+}
+
+/// Sorts [first, last) with a parallel merge sort, not stable
+/// Uses a buffer of the same size, so elements must be default constructible and movable
+template <typename Iterator, typename Compare = std::less<>>
+void parallel_sort(thread_pool &pool, const Iterator first, const Iterator last, Compare comp = {}) {
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<Iterator>::iterator_category>,
+                  "Iterator must be random access");
+
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    if (n <= details::kSortCutoff) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<typename std::iterator_traits<Iterator>::value_type> buffer(n);
+    details::merge_sort(pool, first, buffer.begin(), n, false, comp);
+}
+
+/// Writes the running combination of [first, last) to d_first, like std::inclusive_scan, d_first may be first
+/// Each chunk is reduced in parallel, the chunk totals are scanned, then each chunk is scanned from its carry in
+/// parallel, so op must be associative
+/// \returns end of the output range
+template <typename Input, typename Output, typename Op = std::plus<>>
+Output parallel_inclusive_scan(thread_pool &pool, const Input first, const Input last, const Output d_first,
+                               Op op = {}) {
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<Input>::iterator_category>,
+                  "Input must be random access");
+    using T = typename std::iterator_traits<Input>::value_type;
+
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto chunks = std::min(pool.max_size() + 1, n / details::kScanMinChunk);
+    if (chunks <= 1) {
+        return std::inclusive_scan(first, last, d_first, op);
+    }
+
+    auto chunk_first = [first, n, chunks](const size_t chunk) { return first + n * chunk / chunks; };
+
+    // Total of every chunk but the last, which nothing depends on
+    std::vector<std::optional<T>> carries(chunks);
+    {
+        task_group group(pool);
+        for (size_t chunk = 0; chunk + 1 < chunks; chunk++) {
+            group.spawn([&carries, &chunk_first, &op, chunk] {
+                const auto chunk_last = chunk_first(chunk + 1);
+                auto it = chunk_first(chunk);
+                T total = *it;
+                for (++it; it != chunk_last; ++it) {
+                    total = op(std::move(total), *it);
+                }
+                carries[chunk + 1] = std::move(total);
+            });
+        }
+        group.wait();
+    }
+
+    // Carry into each chunk
+    for (size_t chunk = 2; chunk < chunks; chunk++) {
+        carries[chunk] = op(*carries[chunk - 1], std::move(*carries[chunk]));
+    }
+
+    {
+        task_group group(pool);
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            group.spawn([&carries, &chunk_first, &op, d_first, first, chunk] {
+                const auto out = d_first + (chunk_first(chunk) - first);
+                if (chunk == 0) {
+                    std::inclusive_scan(chunk_first(chunk), chunk_first(chunk + 1), out, op);
+                } else {
+                    std::inclusive_scan(chunk_first(chunk), chunk_first(chunk + 1), out, op, *carries[chunk]);
+                }
+            });
+        }
+        group.wait();
+    }
+
+    return d_first + n;
+}
+
+} // namespace tp
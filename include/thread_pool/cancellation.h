@@ -0,0 +1,64 @@
+#pragma once
+
+#include "thread_pool/errors.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace tp {
+
+/// Observes whether a cancellation_source was cancelled, cheap to copy
+/// A default constructed token is never cancelled
+class cancellation_token {
+  public:
+    cancellation_token() noexcept = default;
+
+    /// Check if cancellation was requested, running tasks may poll this to stop early
+    bool cancelled() const noexcept {
+        return (state_ != nullptr) && state_->load(std::memory_order_acquire);
+    }
+
+    /// Throws task_cancelled if cancellation was requested
+    void throw_if_cancelled() const {
+        if (cancelled()) {
+            throw task_cancelled();
+        }
+    }
+
+  private:
+    friend class cancellation_source;
+
+    explicit cancellation_token(std::shared_ptr<const std::atomic<bool>> state) noexcept : state_(std::move(state)) {}
+
+    /// Flag shared with the source and every other token
+    std::shared_ptr<const std::atomic<bool>> state_;
+};
+
+/// Requests cancellation of every task holding one of its tokens
+/// Cancelling is a single store no matter how many tasks hold a token
+class cancellation_source {
+  public:
+    cancellation_source() : state_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    /// Token observing this source
+    cancellation_token token() const noexcept {
+        return cancellation_token(state_);
+    }
+
+    /// Request cancellation
+    void cancel() noexcept {
+        state_->store(true, std::memory_order_release);
+    }
+
+    /// Check if cancellation was requested
+    bool cancelled() const noexcept {
+        return state_->load(std::memory_order_acquire);
+    }
+
+  private:
+    /// Flag shared with every token
+    std::shared_ptr<std::atomic<bool>> state_;
+};
+
+} // namespace tp
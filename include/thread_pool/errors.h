@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdexcept>
+
+namespace tp {
+
+/// Set on a task's future when its deadline passed before it started
+class deadline_expired : public std::runtime_error {
+  public:
+    deadline_expired() : std::runtime_error("Task deadline expired before it started") {}
+};
+
+/// Set on a task's future when its cancellation token was cancelled before it started
+class task_cancelled : public std::runtime_error {
+  public:
+    task_cancelled() : std::runtime_error("Task cancelled") {}
+};
+
+/// Set on a task's future when the pool's queue was full and the overflow policy rejected it
+class queue_full : public std::runtime_error {
+  public:
+    queue_full() : std::runtime_error("Task queue full") {}
+};
+
+} // namespace tp
@@ -0,0 +1,478 @@
+#pragma once
+
+#include "thread_pool/task.h"
+#include "thread_pool/thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace tp {
+
+template <typename T>
+class future;
+
+template <typename T>
+class promise;
+
+namespace details {
+
+/// What a future holds, void results are stored as an empty placeholder
+template <typename T>
+using stored_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+/// Value or exception a future completed with
+template <typename T>
+struct outcome {
+    std::optional<stored_t<T>> value;
+    std::exception_ptr error;
+
+    /// Returns the value or rethrows the exception
+    T get() {
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(*value);
+        }
+    }
+};
+
+/// State shared between a future and whatever completes it
+template <typename T>
+class future_state {
+  public:
+    /// A state without a pool is only created ready, its continuations run on the thread that attaches them
+    explicit future_state(thread_pool *pool) noexcept : pool_(pool) {}
+
+    thread_pool *pool() const noexcept {
+        return pool_;
+    }
+
+    void set_value(stored_t<T> &&value) {
+        complete([&value](outcome<T> &result) { result.value.emplace(std::move(value)); });
+    }
+
+    void set_exception(std::exception_ptr error) {
+        complete([&error](outcome<T> &result) { result.error = std::move(error); });
+    }
+
+    bool ready() const noexcept {
+        std::scoped_lock lock(lock_);
+        return ready_;
+    }
+
+    /// Runs the callback once ready, either right away or on the thread that completes this state
+    /// Only one callback is supported, it may take the outcome
+    void subscribe(task &&callback) {
+        {
+            std::unique_lock lock(lock_);
+            if (!ready_) {
+                callback_ = std::move(callback);
+                return;
+            }
+        }
+        callback();
+    }
+
+    /// Helps the pool until ready
+    void wait() {
+        // How long to block before looking for work again
+        constexpr auto kRecheckPeriod = std::chrono::microseconds(100);
+
+        while (!ready()) {
+            if (pool_ != nullptr && pool_->run_pending_task()) {
+                continue;
+            }
+
+            std::unique_lock lock(lock_);
+            ready_notifier_.wait_for(lock, kRecheckPeriod, [this] { return ready_; });
+        }
+    }
+
+    /// Moves the outcome out, must be ready
+    outcome<T> take() noexcept {
+        std::scoped_lock lock(lock_);
+        return std::move(outcome_);
+    }
+
+  private:
+    thread_pool *pool_;
+
+    mutable std::mutex lock_;
+    std::condition_variable ready_notifier_;
+    bool ready_ = false;
+    outcome<T> outcome_;
+    task callback_;
+
+    template <typename Set>
+    void complete(Set &&set) {
+        task callback;
+        {
+            std::scoped_lock lock(lock_);
+            if (ready_) {
+                throw std::future_error(std::future_errc::promise_already_satisfied);
+            }
+            set(outcome_);
+            ready_ = true;
+            callback = std::move(callback_);
+        }
+
+        ready_notifier_.notify_all();
+        if (callback) {
+            callback();
+        }
+    }
+};
+
+/// Runs the callable and completes the state with its result or exception
+template <typename T, typename Callable>
+void fulfil(future_state<T> &state, Callable &callable) noexcept {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            callable();
+            state.set_value(std::monostate{});
+        } else {
+            state.set_value(callable());
+        }
+    } catch (...) {
+        state.set_exception(std::current_exception());
+    }
+}
+
+/// Pool task which fulfils a state, or breaks it if the task is destroyed without running, for example because the
+/// pool shut down first, so the future's waiters do not hang
+template <typename T, typename Callable>
+class producer {
+  public:
+    producer(std::shared_ptr<future_state<T>> state, Callable &&callable)
+        : state_(std::move(state)), callable_(std::move(callable)) {}
+
+    /// Movable, the moved from producer no longer owns the state
+    producer(producer &&other) = default;
+    producer &operator=(producer &&other) = default;
+
+    ~producer() {
+        if (state_ != nullptr) {
+            state_->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+    void operator()() noexcept {
+        fulfil(*std::exchange(state_, nullptr), callable_);
+    }
+
+  private:
+    std::shared_ptr<future_state<T>> state_;
+    Callable callable_;
+};
+
+template <typename T, typename Callable>
+producer<T, std::decay_t<Callable>> make_producer(std::shared_ptr<future_state<T>> state, Callable &&callable) {
+    return producer<T, std::decay_t<Callable>>(std::move(state), std::forward<Callable>(callable));
+}
+
+/// First pool among the futures' states, nullptr if none has one
+template <typename Futures>
+thread_pool *pool_of(const Futures &futures) noexcept {
+    for (const auto &future : futures) {
+        if (auto *pool = future.state_->pool(); pool != nullptr) {
+            return pool;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace details
+
+/// Result of when_any, which future finished first and its value
+template <typename T>
+struct when_any_result {
+    size_t index = 0;
+    T value;
+};
+
+template <>
+struct when_any_result<void> {
+    size_t index = 0;
+};
+
+/// Result of a task on a pool, which can be chained without blocking a worker
+/// Move only, get() and then() consume the future
+template <typename T>
+class future {
+  public:
+    /// Empty future
+    future() noexcept = default;
+
+    /// Movable
+    future(future &&other) noexcept = default;
+    future &operator=(future &&other) noexcept = default;
+
+    /// Non copyable
+    future(const future &other) = delete;
+    future &operator=(const future &other) = delete;
+
+    /// Check if this future refers to a result
+    bool valid() const noexcept {
+        return state_ != nullptr;
+    }
+
+    /// Check if the result is available, must be valid
+    bool is_ready() const noexcept {
+        return state_->ready();
+    }
+
+    /// Waits for the result, running the pool's tasks in the meantime so it is safe to call from a worker
+    void wait() const {
+        state_->wait();
+    }
+
+    /// Waits for the result and returns it, or rethrows the task's exception
+    T get() {
+        wait();
+        return std::exchange(state_, nullptr)->take().get();
+    }
+
+    /// Schedules fn on the pool once this future completes, passing the value unless it is void
+    /// If this future completes with an exception fn is skipped and the exception is passed on
+    /// \returns future holding fn's result
+    template <typename Callable>
+    auto then(Callable &&callable) {
+        using Result = typename std::conditional_t<std::is_void_v<T>, std::invoke_result<Callable>,
+                                                   std::invoke_result<Callable, T>>::type;
+
+        auto antecedent = std::exchange(state_, nullptr);
+        auto next = std::make_shared<details::future_state<Result>>(antecedent->pool());
+        auto *source = antecedent.get();
+        source->subscribe([source, next, callable = std::forward<Callable>(callable)]() mutable {
+            auto result = source->take();
+            if (result.error != nullptr) {
+                next->set_exception(result.error);
+                return;
+            }
+
+            auto run = [callable = std::move(callable), result = std::move(result)]() mutable -> Result {
+                if constexpr (std::is_void_v<T>) {
+                    return callable();
+                } else {
+                    return callable(std::move(*result.value));
+                }
+            };
+            auto producer = details::make_producer(next, std::move(run));
+
+            // Only a ready future has no pool, so this is the thread attaching the continuation
+            auto *pool = next->pool();
+            if (pool == nullptr) {
+                producer();
+                return;
+            }
+            details::pool_access::post(*pool, std::move(producer));
+        });
+
+        return future<Result>(std::move(next));
+    }
+
+  private:
+    template <typename U>
+    friend class future;
+
+    template <typename U>
+    friend class promise;
+
+    template <typename Callable, typename ... Args>
+    friend auto async(thread_pool &pool, Callable &&callable, Args && ... args);
+
+    template <typename U>
+    friend future<std::conditional_t<std::is_void_v<U>, void, std::vector<U>>> when_all(std::vector<future<U>> futures);
+
+    template <typename U>
+    friend future<when_any_result<U>> when_any(std::vector<future<U>> futures);
+
+    template <typename Futures>
+    friend thread_pool *details::pool_of(const Futures &futures) noexcept;
+
+    explicit future(std::shared_ptr<details::future_state<T>> state) noexcept : state_(std::move(state)) {}
+
+    std::shared_ptr<details::future_state<T>> state_;
+};
+
+/// Completes a future from outside the pool, for example from an I/O callback
+/// Continuations of the future run on the pool
+template <typename T>
+class promise {
+  public:
+    /// Constructor
+    explicit promise(thread_pool &pool) : state_(std::make_shared<details::future_state<T>>(&pool)) {}
+
+    /// Movable
+    promise(promise &&other) noexcept = default;
+    promise &operator=(promise &&other) noexcept = default;
+
+    /// Non copyable
+    promise(const promise &other) = delete;
+    promise &operator=(const promise &other) = delete;
+
+    /// A promise destroyed without a result breaks its future
+    ~promise() {
+        if (state_ != nullptr && !state_->ready()) {
+            state_->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+    /// Future for the result, may only be called once
+    future<T> get_future() {
+        if (retrieved_) {
+            throw std::future_error(std::future_errc::future_already_retrieved);
+        }
+        retrieved_ = true;
+        return future<T>(state_);
+    }
+
+    template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+    void set_value(U value) {
+        state_->set_value(std::move(value));
+    }
+
+    template <typename U = T, typename = std::enable_if_t<std::is_void_v<U>>>
+    void set_value() {
+        state_->set_value(std::monostate{});
+    }
+
+    void set_exception(std::exception_ptr error) {
+        state_->set_exception(std::move(error));
+    }
+
+  private:
+    std::shared_ptr<details::future_state<T>> state_;
+    bool retrieved_ = false;
+};
+
+/// Runs the callable on the pool
+/// \returns future holding the callable's result
+template <typename Callable, typename ... Args>
+auto async(thread_pool &pool, Callable &&callable, Args && ... args) {
+    auto bound = details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...);
+    using Result = std::invoke_result_t<decltype(bound) &>;
+
+    auto state = std::make_shared<details::future_state<Result>>(&pool);
+    details::pool_access::post(pool, details::make_producer(state, std::move(bound)));
+    return future<Result>(std::move(state));
+}
+
+/// Completes once every future has completed
+/// \returns future holding every value in order, or the first exception, ready right away if futures is empty
+template <typename T>
+future<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> when_all(std::vector<future<T>> futures) {
+    using Result = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+    struct Gather {
+        std::atomic<size_t> remaining;
+        std::vector<std::optional<details::stored_t<T>>> values;
+        std::mutex lock;
+        std::exception_ptr error;
+        std::shared_ptr<details::future_state<Result>> combined;
+    };
+
+    if (futures.empty()) {
+        auto ready = std::make_shared<details::future_state<Result>>(nullptr);
+        if constexpr (std::is_void_v<T>) {
+            ready->set_value(std::monostate{});
+        } else {
+            ready->set_value(std::vector<T>{});
+        }
+        return future<Result>(std::move(ready));
+    }
+
+    auto gather = std::make_shared<Gather>();
+    gather->remaining = futures.size();
+    gather->values.resize(futures.size());
+    gather->combined = std::make_shared<details::future_state<Result>>(details::pool_of(futures));
+    future<Result> combined(gather->combined);
+
+    // Each input completes its slot inline, the last one completes the combined future
+    for (size_t ii = 0; ii < futures.size(); ii++) {
+        // Whoever completes the input keeps it alive while the callback runs
+        auto *source = futures[ii].state_.get();
+        source->subscribe([source, gather, ii] {
+            auto result = source->take();
+            if (result.error != nullptr) {
+                std::scoped_lock lock(gather->lock);
+                if (gather->error == nullptr) {
+                    gather->error = result.error;
+                }
+            } else {
+                gather->values[ii] = std::move(result.value);
+            }
+
+            if (--gather->remaining > 0) {
+                return;
+            }
+
+            if (gather->error != nullptr) {
+                gather->combined->set_exception(gather->error);
+            } else if constexpr (std::is_void_v<T>) {
+                gather->combined->set_value(std::monostate{});
+            } else {
+                std::vector<T> values;
+                values.reserve(gather->values.size());
+                for (auto &value : gather->values) {
+                    values.push_back(std::move(*value));
+                }
+                gather->combined->set_value(std::move(values));
+            }
+        });
+    }
+
+    return combined;
+}
+
+/// Completes once the first future completes
+/// \returns future holding the index and value of the first future to complete, or its exception
+/// If futures is empty nothing can ever complete it, so it is ready right away holding
+/// std::future_error(std::future_errc::broken_promise)
+template <typename T>
+future<when_any_result<T>> when_any(std::vector<future<T>> futures) {
+    using Result = when_any_result<T>;
+
+    if (futures.empty()) {
+        auto broken = std::make_shared<details::future_state<Result>>(nullptr);
+        broken->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        return future<Result>(std::move(broken));
+    }
+
+    auto combined = std::make_shared<details::future_state<Result>>(details::pool_of(futures));
+    auto claimed = std::make_shared<std::atomic<bool>>(false);
+
+    for (size_t ii = 0; ii < futures.size(); ii++) {
+        auto *source = futures[ii].state_.get();
+        source->subscribe([source, combined, claimed, ii] {
+            // Later results are dropped
+            if (claimed->exchange(true)) {
+                return;
+            }
+
+            auto result = source->take();
+            if (result.error != nullptr) {
+                combined->set_exception(result.error);
+            } else if constexpr (std::is_void_v<T>) {
+                combined->set_value(Result{ii});
+            } else {
+                combined->set_value(Result{ii, std::move(*result.value)});
+            }
+        });
+    }
+
+    return future<Result>(std::move(combined));
+}
+
+} // namespace tp
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace tp {
+
+/// Bounded lock free multi producer multi consumer queue
+/// Each slot carries a sequence number which tells producers and consumers whose turn it is,
+/// based on Dmitry Vyukov's bounded MPMC queue
+template <typename T>
+class mpmc_queue {
+  public:
+    /// Constructor, capacity is rounded up to a power of 2
+    explicit mpmc_queue(const size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+
+        mask_ = rounded - 1;
+        slots_ = std::make_unique<Slot[]>(rounded);
+        for (size_t ii = 0; ii < rounded; ii++) {
+            slots_[ii].sequence.store(ii, std::memory_order_relaxed);
+        }
+    }
+
+    /// Destroys any elements left in the queue
+    ~mpmc_queue() {
+        T element;
+        while (try_pop(element)) {
+        }
+    }
+
+    /// Non movable
+    mpmc_queue(mpmc_queue &&other) = delete;
+    mpmc_queue &operator=(mpmc_queue &&other) = delete;
+
+    /// Non copyable
+    mpmc_queue(const mpmc_queue &other) = delete;
+    mpmc_queue &operator=(const mpmc_queue &other) = delete;
+
+    /// Push an element
+    /// \returns false if the queue is full, in which case element is left untouched
+    bool try_push(T &&element) {
+        auto position = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            auto &slot = slots_[position & mask_];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (difference == 0) {
+                // Slot is free for this lap, claim it
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    new (&slot.storage) T(std::move(element));
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // Slot still holds an element from the previous lap
+                return false;
+            } else {
+                // Another producer claimed this position
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Pop an element
+    /// \returns false if the queue is empty
+    bool try_pop(T &element) {
+        auto position = head_.load(std::memory_order_relaxed);
+        while (true) {
+            auto &slot = slots_[position & mask_];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+            if (difference == 0) {
+                // Slot is filled for this lap, claim it
+                if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    auto *stored = std::launder(reinterpret_cast<T *>(&slot.storage));
+                    element = std::move(*stored);
+                    stored->~T();
+                    slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // Nothing published at this position yet
+                return false;
+            } else {
+                // Another consumer claimed this position
+                position = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Maximum number of elements
+    size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+    /// Approximate number of elements
+    size_t size() const noexcept {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        const auto head = head_.load(std::memory_order_relaxed);
+        return (tail > head) ? (tail - head) : 0;
+    }
+
+    /// Approximately empty
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+  private:
+    static constexpr size_t kCacheLineSize = 64;
+
+    struct alignas(kCacheLineSize) Slot {
+        std::atomic<size_t> sequence{0};
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    };
+
+    /// Position of the next element to pop
+    alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+
+    /// Position of the next slot to push to
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+
+    /// Capacity - 1
+    alignas(kCacheLineSize) size_t mask_ = 0;
+
+    /// Ring of slots
+    std::unique_ptr<Slot[]> slots_;
+};
+
+} // namespace tp
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace tp {
+
+/// A place for one thread to sleep until another thread wakes it specifically, backed by a futex
+/// A wakeup that arrives before the thread parks is not lost, the next park returns immediately
+class parking_slot {
+  public:
+    parking_slot() = default;
+
+    /// Non movable
+    parking_slot(parking_slot &&other) = delete;
+    parking_slot &operator=(parking_slot &&other) = delete;
+
+    /// Non copyable
+    parking_slot(const parking_slot &other) = delete;
+    parking_slot &operator=(const parking_slot &other) = delete;
+
+    /// Blocks until unparked
+    void park() noexcept;
+
+    /// Blocks until unparked or the timeout expires
+    /// \returns false if the timeout expired
+    bool park_for(const std::chrono::nanoseconds timeout) noexcept;
+
+    /// Wakes the parked thread, or makes its next park return immediately
+    void unpark() noexcept;
+
+  private:
+    static constexpr uint32_t kEmpty = 0;
+    static constexpr uint32_t kNotified = 1;
+
+    alignas(64) std::atomic<uint32_t> state_{kEmpty};
+};
+
+} // namespace tp
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "thread_pool/thread_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tp {
+
+template <typename T>
+class pipeline_builder;
+
+/// Items flow from a source through a chain of stages on a pool's workers
+/// Serial stages see one item at a time, in source order if in order, parallel stages see many at once
+/// The number of items in flight is capped by the run's token limit, so a slow stage holds back the source
+/// instead of letting items pile up
+class pipeline {
+  public:
+    /// How a stage processes items
+    enum class Mode {
+        /// Any number of items at once
+        kParallel,
+        /// One item at a time, in the order the source produced them
+        kSerialInOrder,
+        /// One item at a time, in any order
+        kSerialOutOfOrder,
+    };
+
+    /// Starts building a pipeline from a source, called serially until it returns nullopt
+    template <typename Source>
+    static auto from(Source &&source) {
+        using Item = typename std::invoke_result_t<Source &>::value_type;
+        return pipeline_builder<Item>(std::make_unique<SourceImpl<Item, std::decay_t<Source>>>(
+            std::forward<Source>(source)));
+    }
+
+    /// Movable
+    pipeline(pipeline &&other) noexcept = default;
+    pipeline &operator=(pipeline &&other) noexcept = default;
+
+    /// Runs until the source is exhausted and every item has left the last stage, helping the pool meanwhile
+    /// If a stage or the source throws, the source stops, items in flight skip the remaining stages and the
+    /// first exception is rethrown
+    /// \param max_tokens Maximum number of items in flight
+    void run(thread_pool &pool, const size_t max_tokens);
+
+  private:
+    template <typename T>
+    friend class pipeline_builder;
+
+    /// Type erased item
+    using Value = std::unique_ptr<void, void (*)(void *)>;
+
+    template <typename T>
+    static Value erase(T &&value) {
+        using Decayed = std::decay_t<T>;
+        return Value(new Decayed(std::forward<T>(value)), [](void *erased) { delete static_cast<Decayed *>(erased); });
+    }
+
+    struct SourceBase {
+        virtual ~SourceBase() = default;
+        virtual std::optional<Value> next() = 0;
+    };
+
+    template <typename T, typename Source>
+    struct SourceImpl : SourceBase {
+        explicit SourceImpl(Source source) : source(std::move(source)) {}
+
+        std::optional<Value> next() override {
+            auto item = source();
+            if (!item.has_value()) {
+                return std::nullopt;
+            }
+            return erase(std::move(item.value()));
+        }
+
+        Source source;
+    };
+
+    struct StageBase {
+        virtual ~StageBase() = default;
+        virtual Value process(Value &&value) = 0;
+    };
+
+    template <typename In, typename Function>
+    struct StageImpl : StageBase {
+        explicit StageImpl(Function function) : function(std::move(function)) {}
+
+        Value process(Value &&value) override {
+            auto &in = *static_cast<In *>(value.get());
+            if constexpr (std::is_void_v<std::invoke_result_t<Function &, In &&>>) {
+                function(std::move(in));
+                return Value(nullptr, [](void *) {});
+            } else {
+                return erase(function(std::move(in)));
+            }
+        }
+
+        Function function;
+    };
+
+    struct Stage {
+        Mode mode;
+        std::unique_ptr<StageBase> function;
+    };
+
+    struct Run;
+
+    explicit pipeline(std::unique_ptr<SourceBase> source, std::vector<Stage> stages) noexcept
+        : source_(std::move(source)), stages_(std::move(stages)) {}
+
+    std::unique_ptr<SourceBase> source_;
+    std::vector<Stage> stages_;
+};
+
+/// Adds stages to a pipeline whose items are currently of type T
+template <typename T>
+class pipeline_builder {
+  public:
+    /// Adds a stage transforming each item with function(T)
+    template <typename Function>
+    auto then(const pipeline::Mode mode, Function &&function) && {
+        using Out = std::invoke_result_t<std::decay_t<Function> &, T &&>;
+        static_assert(!std::is_void_v<Out>, "Only the last stage may return void, add it with to()");
+
+        add(mode, std::forward<Function>(function));
+        return pipeline_builder<Out>(std::move(source_), std::move(stages_));
+    }
+
+    /// Adds the last stage, which consumes each item with function(T)
+    template <typename Function>
+    pipeline to(const pipeline::Mode mode, Function &&function) && {
+        add(mode, std::forward<Function>(function));
+        return pipeline(std::move(source_), std::move(stages_));
+    }
+
+  private:
+    friend class pipeline;
+
+    template <typename U>
+    friend class pipeline_builder;
+
+    explicit pipeline_builder(std::unique_ptr<pipeline::SourceBase> source,
+                              std::vector<pipeline::Stage> stages = {}) noexcept
+        : source_(std::move(source)), stages_(std::move(stages)) {}
+
+    template <typename Function>
+    void add(const pipeline::Mode mode, Function &&function) {
+        stages_.push_back(pipeline::Stage{
+            mode, std::make_unique<pipeline::StageImpl<T, std::decay_t<Function>>>(std::forward<Function>(function))});
+    }
+
+    std::unique_ptr<pipeline::SourceBase> source_;
+    std::vector<pipeline::Stage> stages_;
+};
+
+} // namespace tp
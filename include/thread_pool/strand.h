@@ -0,0 +1,192 @@
+#pragma once
+
+#include "thread_pool/task.h"
+#include "thread_pool/thread_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tp {
+
+namespace details {
+
+/// Queue of tasks which run one at a time, in order, on a pool's workers
+/// At most one drain task per queue is in the pool at any time, and it only holds this queue's lock while
+/// popping, never the pool's
+struct serial_queue {
+    explicit serial_queue(thread_pool &pool) noexcept : pool(pool) {}
+    virtual ~serial_queue() = default;
+
+    /// Called after a drain finds the queue empty and stops
+    virtual void on_idle() noexcept {}
+
+    /// Pool the drain task runs on
+    thread_pool &pool;
+
+    /// Protects tasks and scheduled
+    std::mutex lock;
+
+    /// Tasks not yet run
+    std::deque<task> tasks;
+
+    /// A drain task is queued or running
+    bool scheduled = false;
+};
+
+/// Adds a task and schedules a drain if there is none
+void serial_post(const std::shared_ptr<serial_queue> &queue, task &&work) noexcept;
+
+/// Wraps a callable so its result goes to the returned future
+template <typename Callable, typename ... Args>
+auto serial_package(Callable &&callable, Args && ... args) {
+    auto bound = details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...);
+    using Result = std::invoke_result_t<decltype(bound) &>;
+
+    std::packaged_task<Result()> packaged(std::move(bound));
+    auto future = packaged.get_future();
+    return std::make_pair(task(std::move(packaged)), std::move(future));
+}
+
+} // namespace details
+
+/// Runs tasks one at a time in submission order on a shared pool, without a dedicated thread
+/// Copies refer to the same strand
+class strand {
+  public:
+    /// Constructor
+    explicit strand(thread_pool &pool) : queue_(std::make_shared<details::serial_queue>(pool)) {}
+
+    /// Push a task without a future, it must not throw
+    template <typename Callable, typename ... Args>
+    void post(Callable &&callable, Args && ... args) noexcept {
+        details::serial_post(queue_, task(details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...)));
+    }
+
+    /// Push a task
+    /// \returns future holding the callable's result
+    template <typename Callable, typename ... Args>
+    auto push(Callable &&callable, Args && ... args) noexcept {
+        auto [work, future] = details::serial_package(std::forward<Callable>(callable), std::forward<Args>(args)...);
+        details::serial_post(queue_, std::move(work));
+        return std::move(future);
+    }
+
+  private:
+    /// Shared with the drain task
+    std::shared_ptr<details::serial_queue> queue_;
+};
+
+/// Runs tasks with the same key one at a time in submission order, tasks with different keys in parallel
+/// Each key with queued or running tasks gets its own strand, which is dropped as soon as it goes idle,
+/// so memory follows the number of active keys rather than the number of keys ever seen
+template <typename Key, typename Hash = std::hash<Key>>
+class serial_executor {
+  public:
+    /// Constructor, keys are spread over shards with their own locks
+    explicit serial_executor(thread_pool &pool, const size_t shards = 64)
+        : pool_(pool), shards_(std::make_shared<Shards>(std::max<size_t>(shards, 1))) {}
+
+    /// Non movable
+    serial_executor(serial_executor &&other) = delete;
+    serial_executor &operator=(serial_executor &&other) = delete;
+
+    /// Non copyable
+    serial_executor(const serial_executor &other) = delete;
+    serial_executor &operator=(const serial_executor &other) = delete;
+
+    /// Push a task without a future to the key's strand, it must not throw
+    template <typename Callable, typename ... Args>
+    void post(const Key &key, Callable &&callable, Args && ... args) noexcept {
+        enqueue(key, task(details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...)));
+    }
+
+    /// Push a task to the key's strand
+    /// \returns future holding the callable's result
+    template <typename Callable, typename ... Args>
+    auto push(const Key &key, Callable &&callable, Args && ... args) noexcept {
+        auto [work, future] = details::serial_package(std::forward<Callable>(callable), std::forward<Args>(args)...);
+        enqueue(key, std::move(work));
+        return std::move(future);
+    }
+
+    /// Number of keys with queued or running tasks
+    size_t active() const noexcept {
+        size_t count = 0;
+        for (auto &shard : *shards_) {
+            std::scoped_lock lock(shard.lock);
+            count += shard.strands.size();
+        }
+        return count;
+    }
+
+  private:
+    struct Queue;
+
+    struct Shard {
+        mutable std::mutex lock;
+        std::unordered_map<Key, std::shared_ptr<Queue>, Hash> strands;
+    };
+
+    using Shards = std::vector<Shard>;
+
+    /// A key's strand, removes itself from its shard when it goes idle
+    struct Queue : details::serial_queue {
+        Queue(thread_pool &pool, const Key &key, std::weak_ptr<Shards> shards)
+            : details::serial_queue(pool), key(key), shards(std::move(shards)) {}
+
+        void on_idle() noexcept override {
+            // The executor may be gone, in which case nobody can post to this strand again
+            const auto table = shards.lock();
+            if (table == nullptr) {
+                return;
+            }
+
+            // Shard before queue, the same order as enqueue, so a post either lands before this check or
+            // finds the strand gone and makes a new one
+            auto &shard = (*table)[Hash{}(key) % table->size()];
+            std::scoped_lock shard_lock(shard.lock);
+            const auto it = shard.strands.find(key);
+            if (it == shard.strands.end() || it->second.get() != this) {
+                return;
+            }
+
+            std::scoped_lock queue_lock(lock);
+            if (!scheduled && tasks.empty()) {
+                shard.strands.erase(it);
+            }
+        }
+
+        const Key key;
+        const std::weak_ptr<Shards> shards;
+    };
+
+    /// Pool the strands run on
+    thread_pool &pool_;
+
+    /// Strands of active keys
+    const std::shared_ptr<Shards> shards_;
+
+    /// Adds a task to the key's strand, creating it if the key is idle
+    void enqueue(const Key &key, task &&work) noexcept {
+        auto &shard = (*shards_)[Hash{}(key) % shards_->size()];
+        std::scoped_lock lock(shard.lock);
+
+        auto &queue = shard.strands[key];
+        if (queue == nullptr) {
+            queue = std::make_shared<Queue>(pool_, key, shards_);
+        }
+
+        // Posting under the shard lock keeps the strand from being dropped in between
+        details::serial_post(queue, std::move(work));
+    }
+};
+
+} // namespace tp
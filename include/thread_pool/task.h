@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace tp {
+
+/// Move only type erased void() callable
+/// Callables that fit in kInlineSize bytes and are nothrow movable are stored inline without allocating
+class task {
+  public:
+    /// Inline storage size, fits a packaged_task or a lambda capturing a handful of pointers
+    static constexpr size_t kInlineSize = 48;
+
+    /// Empty task
+    task() noexcept = default;
+
+    /// Wraps a callable
+    template <typename Callable,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, task>>>
+    task(Callable &&callable) {
+        using Decayed = std::decay_t<Callable>;
+        static_assert(std::is_invocable_v<Decayed &>, "Callable must be invocable with no arguments");
+
+        if constexpr (fits_inline<Decayed>()) {
+            new (&storage_) Decayed(std::forward<Callable>(callable));
+            ops_ = &kInlineOps<Decayed>;
+        } else {
+            new (&storage_) Decayed *(new Decayed(std::forward<Callable>(callable)));
+            ops_ = &kHeapOps<Decayed>;
+        }
+    }
+
+    /// Movable
+    task(task &&other) noexcept {
+        move_from(other);
+    }
+
+    task &operator=(task &&other) noexcept {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    /// Non copyable
+    task(const task &other) = delete;
+    task &operator=(const task &other) = delete;
+
+    ~task() {
+        reset();
+    }
+
+    /// Check if a callable is stored
+    bool valid() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    explicit operator bool() const noexcept {
+        return valid();
+    }
+
+    /// Invoke the callable, must be valid
+    void operator()() {
+        ops_->invoke(&storage_);
+    }
+
+    /// Stored callable if it is a Callable, nullptr otherwise, like std::function::target
+    template <typename Callable>
+    Callable *target() noexcept {
+        if (ops_ == &kInlineOps<Callable>) {
+            return std::launder(reinterpret_cast<Callable *>(&storage_));
+        }
+        if (ops_ == &kHeapOps<Callable>) {
+            return *std::launder(reinterpret_cast<Callable **>(&storage_));
+        }
+        return nullptr;
+    }
+
+    /// Destroys the stored callable
+    void reset() noexcept {
+        if (ops_ != nullptr) {
+            ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+    }
+
+  private:
+    /// Operations on the storage for one callable type
+    struct Ops {
+        void (*invoke)(void *storage);
+        void (*move)(void *destination, void *source) noexcept;
+        void (*destroy)(void *storage) noexcept;
+    };
+
+    template <typename Callable>
+    static constexpr bool fits_inline() {
+        return (sizeof(Callable) <= kInlineSize) &&
+               (alignof(std::max_align_t) % alignof(Callable) == 0) &&
+               std::is_nothrow_move_constructible_v<Callable>;
+    }
+
+    /// Callable lives in the storage
+    template <typename Callable>
+    static constexpr Ops kInlineOps{
+        [](void *storage) {
+            std::invoke(*std::launder(static_cast<Callable *>(storage)));
+        },
+        [](void *destination, void *source) noexcept {
+            auto *callable = std::launder(static_cast<Callable *>(source));
+            new (destination) Callable(std::move(*callable));
+            callable->~Callable();
+        },
+        [](void *storage) noexcept {
+            std::launder(static_cast<Callable *>(storage))->~Callable();
+        },
+    };
+
+    /// Storage holds a pointer to the callable
+    template <typename Callable>
+    static constexpr Ops kHeapOps{
+        [](void *storage) {
+            std::invoke(**std::launder(static_cast<Callable **>(storage)));
+        },
+        [](void *destination, void *source) noexcept {
+            new (destination) Callable *(*std::launder(static_cast<Callable **>(source)));
+        },
+        [](void *storage) noexcept {
+            delete *std::launder(static_cast<Callable **>(storage));
+        },
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops *ops_ = nullptr;
+
+    void move_from(task &other) noexcept {
+        if (other.ops_ != nullptr) {
+            other.ops_->move(&storage_, &other.storage_);
+            ops_ = std::exchange(other.ops_, nullptr);
+        }
+    }
+};
+
+} // namespace tp
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "thread_pool/task.h"
+#include "thread_pool/thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace tp {
+
+/// Graph of tasks where each node runs once all of its predecessors have finished
+/// Every node counts its unfinished predecessors atomically and is pushed to the pool by whichever predecessor
+/// finishes last, so there are no barriers between waves of work
+/// A graph can be run any number of times, runs only reset counters and do not allocate
+class task_graph {
+  public:
+    /// Node handle
+    using node = size_t;
+
+    /// Constructor
+    task_graph() noexcept = default;
+
+    /// Non movable
+    task_graph(task_graph &&other) = delete;
+    task_graph &operator=(task_graph &&other) = delete;
+
+    /// Non copyable
+    task_graph(const task_graph &other) = delete;
+    task_graph &operator=(const task_graph &other) = delete;
+
+    /// Adds a node, the callable is invoked once per run
+    template <typename Callable, typename ... Args>
+    node add(Callable &&callable, Args && ... args) {
+        nodes_.push_back(Node{task(details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...))});
+        validated_ = false;
+        return nodes_.size() - 1;
+    }
+
+    /// Makes successor wait for predecessor in every run
+    void depends_on(const node successor, const node predecessor);
+
+    /// Number of nodes
+    size_t size() const noexcept;
+
+    /// Runs every node once on the pool and waits for all of them, helping the pool in the meantime
+    /// Only one run at a time
+    /// If a node throws, nodes that have not started yet are skipped and the first exception is rethrown
+    /// Throws std::invalid_argument if the graph has a cycle
+    void run(thread_pool &pool);
+
+  private:
+    struct Node {
+        task work;
+        std::vector<node> successors{};
+        size_t predecessors = 0;
+    };
+
+    /// Where the last node of a run signals run(), shared so it outlives a graph destroyed as soon as run() returns
+    struct Completion {
+        std::mutex lock;
+        std::condition_variable done;
+    };
+
+    /// Nodes in the order they were added
+    std::vector<Node> nodes_;
+
+    /// Nodes without predecessors
+    std::vector<node> roots_;
+
+    /// Unfinished predecessors of each node in the current run
+    std::unique_ptr<std::atomic<size_t>[]> remaining_;
+
+    /// The graph was checked for cycles since it last changed
+    bool validated_ = false;
+
+    /// Pool of the current run
+    thread_pool *pool_ = nullptr;
+
+    /// Nodes of the current run which have not finished
+    std::atomic<size_t> unfinished_{0};
+
+    /// Signalled when unfinished_ drops to 0
+    std::shared_ptr<Completion> completion_;
+
+    /// A node of the current run threw
+    std::atomic<bool> failed_{false};
+
+    /// Protects exception_
+    std::mutex lock_;
+    std::exception_ptr exception_;
+
+    /// Checks for cycles, finds the roots and sizes the counters
+    void validate();
+
+    /// Runs a node and then whichever successors it made ready
+    void execute(node index) noexcept;
+};
+
+} // namespace tp
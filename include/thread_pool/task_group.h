@@ -0,0 +1,84 @@
+#pragma once
+
+#include "thread_pool/thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace tp {
+
+/// Set of tasks spawned onto a pool and waited on together
+/// Waiting runs the pool's queued tasks instead of blocking, so tasks may spawn and wait on nested groups
+/// without deadlocking a small pool
+class task_group {
+  public:
+    /// Constructor
+    explicit task_group(thread_pool &pool) noexcept;
+
+    /// Waits for every spawned task, exceptions which were not collected by wait() are dropped
+    ~task_group() noexcept;
+
+    /// Non movable
+    task_group(task_group &&other) = delete;
+    task_group &operator=(task_group &&other) = delete;
+
+    /// Non copyable
+    task_group(const task_group &other) = delete;
+    task_group &operator=(const task_group &other) = delete;
+
+    /// Push a task belonging to this group
+    template <typename Callable, typename ... Args>
+    void spawn(Callable &&callable, Args && ... args) noexcept {
+        state_->pending++;
+        auto bound = details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...);
+        details::pool_access::post(pool_, [state = state_, bound = std::move(bound)]() mutable {
+            try {
+                bound();
+            } catch (...) {
+                state->fail(std::current_exception());
+            }
+            state->finish();
+        });
+    }
+
+    /// Runs pool tasks until every spawned task has finished
+    /// Rethrows the first exception thrown by a spawned task
+    void wait();
+
+  private:
+    /// State shared with the spawned tasks, which may finish after the group is destroyed
+    struct State {
+        /// Number of spawned tasks which have not finished
+        std::atomic<size_t> pending{0};
+
+        /// Protects the fields below
+        std::mutex lock;
+
+        /// Signalled when the last task finishes
+        std::condition_variable done;
+
+        /// First exception thrown by a task
+        std::exception_ptr exception;
+
+        /// Records an exception if it is the first
+        void fail(std::exception_ptr thrown) noexcept;
+
+        /// Marks one task finished
+        void finish() noexcept;
+    };
+
+    /// Pool the tasks run on
+    thread_pool &pool_;
+
+    /// Shared state
+    std::shared_ptr<State> state_;
+
+    /// Helps the pool until every spawned task has finished
+    void help() noexcept;
+};
+
+} // namespace tp
@@ -2,9 +2,10 @@
 
 #include "thread_pool/utils.h"
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
-#include <mutex>
 #include <optional>
 #include <type_traits>
 
@@ -71,26 +72,33 @@ class thread {
     void detach() noexcept;
 
   private:
-    using StoreIdCallback = std::function<void(const size_t)>;
-
-    /// Callbacks for the thread wrapper to execute
+    /// State shared between this object and the spawned thread, in a single allocation
     struct ThreadParams {
+        /// Callback for the thread wrapper to execute
         Callback run_callback{};
-        StoreIdCallback store_id_callback{};
+
+        /// Thread ID, 0 until the thread publishes it
+        std::atomic<size_t> id{0};
+
+        /// Number of owners, this object and the spawned thread
+        std::atomic<uint32_t> references{1};
+
+        /// Drops one reference, the last owner frees the state
+        struct Release {
+            void operator()(ThreadParams *params) const noexcept;
+        };
     };
 
+    using ThreadParamsPtr = std::unique_ptr<ThreadParams, ThreadParams::Release>;
+
     /// To print errors or not
     const bool print_errors_ = true;
 
     /// Thread handle
     std::optional<size_t> handle_;
 
-    /// Thread ID
-    class Id;
-    std::shared_ptr<Id> id_;
-
-    /// Parameters to pass to thread
-    std::unique_ptr<ThreadParams> thread_params_ = std::make_unique<ThreadParams>();
+    /// Parameters shared with the thread
+    ThreadParamsPtr thread_params_{new ThreadParams()};
 
     /// Wraps the callback in a function that is compliant with pthread
     static void *thread_wrapper(void *params);
@@ -1,23 +1,144 @@
 #pragma once
 
+#include "thread_pool/cancellation.h"
+#include "thread_pool/errors.h"
+#include "thread_pool/mpmc_queue.h"
+#include "thread_pool/parking_slot.h"
+#include "thread_pool/task.h"
 #include "thread_pool/thread.h"
+#include "thread_pool/timer_wheel.h"
+#include "thread_pool/work_stealing_deque.h"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <future>
+#include <iterator>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <optional>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace tp {
 
+/// Priority of a task, 0 is the highest and the default
+struct priority {
+    size_t level = 0;
+};
+
+namespace details {
+
+struct pool_access;
+
+} // namespace details
+
 class thread_pool {
   public:
+    /// How tasks are distributed to workers
+    enum class Scheduler {
+        /// One queue shared by all workers
+        kGlobalQueue,
+        /// Each worker owns a deque, tasks pushed from a worker stay local, idle workers steal
+        kWorkStealing,
+    };
+
+    /// Backing structure of the shared queue
+    enum class Queue {
+        /// Unbounded std::queue protected by the pool's lock
+        kMutex,
+        /// Bounded lock free ring, producers yield while it is full
+        kLockFree,
+    };
+
+    /// How idle workers wait for tasks
+    enum class WaitPolicy {
+        /// Block straight away
+        kBlock,
+        /// Spin with a pause instruction, then block
+        kSpin,
+        /// Spin with a pause instruction, then yield the processor, then block
+        kSpinYield,
+    };
+
+    /// How workers pick between priority lanes
+    enum class Dispatch {
+        /// Always the highest priority lane with a task
+        kStrict,
+        /// Lanes are visited in proportion to their weights, so low priorities cannot starve
+        kWeighted,
+    };
+
+    /// What push(), post(), push_bulk() and push_n() do while the queue is full, try_push() fails instead
+    enum class Overflow {
+        /// Wait for a task to start, a worker of this pool runs the task itself instead
+        kBlock,
+        /// Fail the task's future with queue_full
+        kReject,
+        /// Evict the oldest pushed or posted task in the shared queue, lowest priority first, breaking its future
+        /// The lock free ring can only pop its oldest task whatever it is, so it rejects instead
+        kDropOldest,
+        /// Run the task on the calling thread
+        kCallerRuns,
+    };
+
     /// Parameters
     struct Params {
         thread::Params thread_params{};
         size_t size = 1;
+        Scheduler scheduler = Scheduler::kGlobalQueue;
+        Queue queue = Queue::kMutex;
+        /// Capacity of the lock free ring
+        size_t queue_capacity = 1024;
+        /// Maximum number of tasks a worker takes from the mutex queue per lock acquisition
+        size_t batch_size = 1;
+        WaitPolicy wait_policy = WaitPolicy::kBlock;
+        /// Iterations of each busy waiting phase
+        size_t spin_count = 4096;
+        /// If set, a worker skips busy waiting while its average idle period is longer than this
+        std::optional<std::chrono::nanoseconds> adaptive_threshold{};
+        /// Number of priority lanes, priorities past the last lane go to the last lane
+        size_t priority_levels = 1;
+        Dispatch dispatch = Dispatch::kStrict;
+        /// Weight of each lane for weighted dispatch, defaults to 2^(levels - 1 - lane)
+        std::vector<size_t> priority_weights{};
+        /// Tasks with a deadline run before all other tasks, earliest deadline first
+        /// Otherwise they are queued in the default lane like any other task
+        bool earliest_deadline_first = false;
+        /// Granularity of scheduled tasks, they never run early but may run up to this much late
+        std::chrono::nanoseconds timer_resolution = std::chrono::milliseconds(1);
+        /// Maximum number of tasks waiting to start before push(), post(), push_bulk() and push_n() apply the overflow
+        /// policy, 0 for unbounded
+        /// Scheduled tasks and the continuations of futures, strands, task groups, task graphs and pipelines go
+        /// through the unbounded details::pool_access::post, so nothing waiting on them can hang
+        size_t max_queue_size = 0;
+        Overflow overflow = Overflow::kBlock;
+        /// The inline policy below applies to push(), post(), push_bulk() and push_n(), never to try_push() or the
+        /// unbounded details::pool_access::post, a bulk push subject to it is submitted one task at a time
+        /// A push from a worker of this pool runs the task inline, the worker would likely be the one to run it anyway
+        bool inline_from_worker = false;
+        /// A push runs the task inline once this many tasks are waiting to start, 0 to disable
+        size_t inline_queue_depth = 0;
+        /// If set, a push runs the task inline once the estimated wait for a worker is longer than this
+        std::optional<std::chrono::nanoseconds> inline_wait{};
+        /// Most inline tasks nested on one thread, deeper pushes are queued so recursive tasks cannot overflow the stack
+        size_t max_inline_depth = 16;
+        /// If larger than size, the pool spawns workers up to this many while tasks wait too long to start, and
+        /// retires them down to size once they idle
+        size_t max_size = 0;
+        /// How long the oldest waiting task may have waited before another worker is spawned
+        std::chrono::nanoseconds grow_threshold = std::chrono::milliseconds(5);
+        /// How long a worker above size idles before it retires
+        std::chrono::nanoseconds keep_alive = std::chrono::seconds(10);
+        /// Least time between two resizes, so bursty load does not spawn and retire workers back to back
+        std::chrono::nanoseconds resize_cooldown = std::chrono::milliseconds(10);
     };
 
+    using clock = std::chrono::steady_clock;
+
     /// Constructor
     thread_pool(const Params &params) noexcept;
 
@@ -33,58 +154,541 @@ class thread_pool {
     thread_pool &operator=(const thread_pool &other) = delete;
 
     /// Push a task to the task queue
+    /// \returns future holding the callable's result
+    template <typename Callable, typename ... Args>
+    auto push(Callable &&callable, Args && ... args) noexcept {
+        return push(priority{}, std::forward<Callable>(callable), std::forward<Args>(args)...);
+    }
+
+    /// Push a task to the lane for its priority
+    /// \returns future holding the callable's result
+    template <typename Callable, typename ... Args>
+    auto push(const priority task_priority, Callable &&callable, Args && ... args) noexcept {
+        auto [task, future] = package(std::forward<Callable>(callable), std::forward<Args>(args)...);
+
+        // Add to queue and wake up a thread, future for caller to understand when the task is complete
+        return submit(std::move(task), std::move(future),
+                      [this, level = task_priority.level](Task &&task) { enqueue(std::move(task), level); });
+    }
+
+    /// Push a task only if the queue has room, never blocks or runs the task on the calling thread
+    /// \returns future holding the callable's result, or nullopt if the queue is full
+    template <typename Callable, typename ... Args>
+    auto try_push(Callable &&callable, Args && ... args) noexcept {
+        auto [task, future] = package(std::forward<Callable>(callable), std::forward<Args>(args)...);
+        using Future = decltype(future);
+
+        if (full()) {
+            return std::optional<Future>{};
+        }
+
+        enqueue(std::move(task));
+        return std::optional<Future>(std::move(future));
+    }
+
+    /// Push a task which must start before the deadline
+    /// \returns future holding the callable's result, or deadline_expired if the task was dropped
+    template <typename Callable, typename ... Args>
+    auto push(const clock::time_point deadline, Callable &&callable, Args && ... args) noexcept {
+        auto bound = details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...);
+        auto [task, future] = package([deadline, bound = std::move(bound)]() mutable {
+            // Late work is dropped rather than wasting a worker on it
+            if (clock::now() > deadline) {
+                throw deadline_expired();
+            }
+            return bound();
+        });
+
+        return submit(std::move(task), std::move(future), [this, deadline](Task &&task) {
+            if (earliest_deadline_first_) {
+                enqueue_deadline(std::move(task), deadline);
+            } else {
+                enqueue(std::move(task));
+            }
+        });
+    }
+
+    /// Push a task which is skipped if the token is cancelled before it starts
+    /// The task may poll the token itself to stop early
+    /// \returns future holding the callable's result, or task_cancelled if the task was skipped
+    template <typename Callable, typename ... Args>
+    auto push(cancellation_token token, Callable &&callable, Args && ... args) noexcept {
+        auto bound = details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...);
+        auto [task, future] = package([token = std::move(token), bound = std::move(bound)]() mutable {
+            token.throw_if_cancelled();
+            return bound();
+        });
+
+        return submit(std::move(task), std::move(future), [this](Task &&task) { enqueue(std::move(task)); });
+    }
+
+    /// Push a task to the task queue without a future, the cheapest way to submit work
+    /// The task must not throw, an escaping exception terminates the worker's process
+    /// \returns false if the queue was full and the overflow policy rejected the task
+    template <typename Callable, typename ... Args>
+    bool post(Callable &&callable, Args && ... args) noexcept {
+        return submit(Task(details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...)),
+                      [this](Task &&task) { enqueue(std::move(task)); });
+    }
+
+    /// Push every callable in [first, last), under one lock acquisition if they all fit in the queue
+    /// \returns futures in the same order as the callables
+    template <typename Iterator>
+    auto push_bulk(Iterator first, Iterator last) noexcept {
+        using Callable = typename std::iterator_traits<Iterator>::value_type;
+        using Result = std::invoke_result_t<Callable &>;
+
+        std::vector<Task> tasks;
+        std::vector<std::future<Result>> futures;
+        const auto n = static_cast<size_t>(std::distance(first, last));
+        tasks.reserve(n);
+        futures.reserve(n);
+
+        for (; first != last; ++first) {
+            std::packaged_task<Result()> packaged(*first);
+            futures.push_back(packaged.get_future());
+            tasks.emplace_back(std::move(packaged));
+        }
+
+        submit_bulk(std::move(tasks), futures);
+        return futures;
+    }
+
+    /// Push n tasks which call callable(i) for i in [0, n), under one lock acquisition if they all fit in the queue
+    /// \returns futures in index order
+    template <typename Callable>
+    auto push_n(const size_t n, Callable &&callable) noexcept {
+        using Result = std::invoke_result_t<Callable &, size_t>;
+
+        std::vector<Task> tasks;
+        std::vector<std::future<Result>> futures;
+        tasks.reserve(n);
+        futures.reserve(n);
+
+        for (size_t ii = 0; ii < n; ii++) {
+            std::packaged_task<Result()> packaged([callable, ii]() mutable { return callable(ii); });
+            futures.push_back(packaged.get_future());
+            tasks.emplace_back(std::move(packaged));
+        }
+
+        submit_bulk(std::move(tasks), futures);
+        return futures;
+    }
+
+    /// Post a task once the delay has passed, tasks still scheduled when the pool is joined are dropped
+    /// \returns handle to cancel the task before it is posted
     template <typename Callable, typename ... Args>
-    std::future<void> push(Callable &&callable, Args && ... args) noexcept {
-        // Create task
-        auto callback = details::construct(std::forward<Callable>(callable),
-                                           std::forward<Args>(args)...);
-        Task task(std::move(callback));
-        auto future = task.get_future();
+    timer_handle schedule_after(const clock::duration delay, Callable &&callable, Args && ... args) noexcept {
+        return schedule_at(clock::now() + delay, std::forward<Callable>(callable), std::forward<Args>(args)...);
+    }
 
-        // Add to queue and wake up a thread
-        std::scoped_lock lock(lock_);
-        q_.push(std::move(task));
-        q_push_notifier_.notify_one();
+    /// Post a task once the time point has passed
+    /// \returns handle to cancel the task before it is posted
+    template <typename Callable, typename ... Args>
+    timer_handle schedule_at(const clock::time_point when, Callable &&callable, Args && ... args) noexcept {
+        return schedule(when, clock::duration::zero(),
+                        Task(details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...)));
+    }
 
-        // Future for caller to understand when the task is complete
-        return future;
+    /// Post a task every period, starting one period from now
+    /// Runs never overlap, a firing while the previous run is still in flight is skipped rather than queued so a slow
+    /// task does not pile up a backlog of runs
+    /// \returns handle to stop posting the task
+    template <typename Callable, typename ... Args>
+    timer_handle schedule_every(const clock::duration period, Callable &&callable, Args && ... args) noexcept {
+        return schedule(clock::now() + period, period,
+                        Task(details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...)));
     }
 
+    /// Cancels a scheduled task, a periodic task may still have one run in flight
+    /// \returns false if the task was already posted or cancelled
+    bool cancel(const timer_handle timer) noexcept;
+
+    /// Index of the calling worker in [0, max_size()), or nullopt if the calling thread does not belong to this pool
+    std::optional<size_t> worker_index() const noexcept;
+
+    /// Runs one queued task on the calling thread, so a thread waiting on the pool's work can help instead of blocking
+    /// \returns false if there was nothing to run
+    bool run_pending_task() noexcept;
+
     /// Joins all threads
     /// \param finish_queue To finish the queue before joining or not
     void join(const bool finish_queue) noexcept;
 
-    /// Thread pool size
+    /// Number of live workers, only changes on its own if the pool is elastic
     size_t size() const noexcept;
 
+    /// Most workers the pool can have, size() unless the pool is elastic
+    size_t max_size() const noexcept;
+
     /// Current queue size
     size_t qsize() const noexcept;
 
   private:
-    using Callback = thread::Callback;
-    using Task = std::packaged_task<details::function_type<Callback>::type>;
+    friend struct details::pool_access;
+
+    using Task = task;
+
+    /// Binds the callable into a task
+    /// \returns the task and the future for its result
+    template <typename Callable, typename ... Args>
+    static auto package(Callable &&callable, Args && ... args) {
+        auto bound = details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...);
+        using Result = std::invoke_result_t<decltype(bound) &>;
+
+        // The bound callable and the result live in the packaged_task's shared state and
+        // the packaged_task itself fits in the task's inline storage
+        std::packaged_task<Result()> packaged(std::move(bound));
+        auto future = packaged.get_future();
+        return std::make_pair(Task(std::move(packaged)), std::move(future));
+    }
+
+    /// Worker index for threads outside the pool
+    static constexpr size_t kNotWorker = SIZE_MAX;
+
+    /// What happens to a task pushed while the queue is full
+    enum class Admission {
+        kQueue,
+        kInline,
+        kReject,
+    };
+
+    /// A task kDropOldest may evict, only tasks submitted through the public API are wrapped in one
+    struct Evictable {
+        Task task;
+
+        void operator()() {
+            task();
+        }
+    };
+
+    /// Checks if the overflow policy applies
+    bool full() const noexcept {
+        return (max_queue_size_ > 0) && (pending_ >= max_queue_size_);
+    }
+
+    /// Marks a task as evictable, only while kDropOldest may evict since it costs an allocation
+    Task evictable(Task &&task) noexcept {
+        if (overflow_ != Overflow::kDropOldest || max_queue_size_ == 0 || !rings_.empty()) {
+            return std::move(task);
+        }
+        return Task(Evictable{std::move(task)});
+    }
+
+    /// Queues a task with add, unless the inline policy runs it on the calling thread or the queue is full, in
+    /// which case the overflow policy decides
+    /// \returns false if the task was rejected
+    template <typename Add>
+    bool submit(Task &&task, Add &&add) noexcept {
+        switch ((inline_policy_ || full()) ? admit() : Admission::kQueue) {
+        case Admission::kQueue:
+            add(evictable(std::move(task)));
+            return true;
+        case Admission::kInline:
+            run_inline(task);
+            return true;
+        case Admission::kReject:
+            break;
+        }
+
+        return false;
+    }
+
+    /// Submits a packaged task
+    /// \returns the task's future, or a future holding queue_full if it was rejected
+    template <typename Result, typename Add>
+    std::future<Result> submit(Task &&task, std::future<Result> &&future, Add &&add) noexcept {
+        if (submit(std::move(task), std::forward<Add>(add))) {
+            return std::move(future);
+        }
+
+        std::promise<Result> rejected;
+        rejected.set_exception(std::make_exception_ptr(queue_full()));
+        return rejected.get_future();
+    }
+
+    /// Submits packaged tasks, all at once if they fit in the queue and nothing may run inline, otherwise one by one
+    /// Rejected tasks get a future holding queue_full instead
+    template <typename Result>
+    void submit_bulk(std::vector<Task> &&tasks, std::vector<std::future<Result>> &futures) noexcept {
+        if (!inline_policy_ && (max_queue_size_ == 0 || pending_ + tasks.size() <= max_queue_size_)) {
+            for (auto &task : tasks) {
+                task = evictable(std::move(task));
+            }
+            enqueue_bulk(std::move(tasks));
+            return;
+        }
+
+        for (size_t ii = 0; ii < tasks.size(); ii++) {
+            futures[ii] = submit(std::move(tasks[ii]), std::move(futures[ii]),
+                                 [this](Task &&task) { enqueue(std::move(task)); });
+        }
+    }
+
+    /// Minimum number of workers, started by the constructor
+    const size_t size_;
+
+    /// Maximum number of workers, every per worker structure is sized for this many
+    const size_t capacity_;
+
+    /// Elastic sizing
+    const clock::duration grow_threshold_;
+    const clock::duration keep_alive_;
+    const clock::duration resize_cooldown_;
+
+    /// Number of live workers
+    std::atomic<size_t> live_{0};
+
+    /// Time of the last resize since timer_epoch_, shared by growing and retiring to enforce the cooldown
+    std::atomic<clock::rep> last_resize_{0};
+
+    /// Number of tasks ever published, tasks published before a given count have all started once
+    /// published_total_ - pending_ reaches it
+    std::atomic<size_t> published_total_{0};
+
+    /// Oldest published count not known to have started and when it was taken, only used by the timer thread
+    size_t wait_mark_ = 0;
+    clock::time_point wait_mark_time_{};
+
+    /// Scheduling mode
+    const Scheduler scheduler_;
+
+    /// Maximum tasks dequeued per lock acquisition
+    const size_t batch_size_;
+
+    /// Bound on pending tasks for push(), post(), push_bulk() and push_n(), 0 for unbounded
+    const size_t max_queue_size_;
+    const Overflow overflow_;
+
+    /// Inline execution policy for push(), post(), push_bulk() and push_n()
+    const bool inline_from_worker_;
+    const size_t inline_queue_depth_;
+    const std::optional<std::chrono::nanoseconds> inline_wait_;
+    const size_t max_inline_depth_;
+
+    /// Any of the inline triggers is enabled
+    const bool inline_policy_;
+
+    /// Moving average of how long a task runs in nanoseconds, only tracked for inline_wait
+    std::atomic<int64_t> average_task_ns_{0};
+
+    /// A task waiting in the deadline heap
+    struct DeadlineTask {
+        clock::time_point deadline;
+        Task task;
+
+        /// Orders the heap so the earliest deadline is on top
+        bool operator>(const DeadlineTask &other) const noexcept {
+            return deadline > other.deadline;
+        }
+    };
+
+    /// Priority dispatch
+    const Dispatch dispatch_;
+
+    /// Earliest deadline first dispatch
+    const bool earliest_deadline_first_;
+
+    /// Running sum of lane weights, lane i owns tickets [cumulative_weights_[i - 1], cumulative_weights_[i])
+    std::vector<size_t> cumulative_weights_;
+
+    /// Ticket for weighted dispatch
+    std::atomic<size_t> dispatch_ticket_{0};
+
+    /// Idle strategy
+    const WaitPolicy wait_policy_;
+    const size_t spin_count_;
+    const std::optional<std::chrono::nanoseconds> adaptive_threshold_;
 
     /// Flag to stop all threads
     std::atomic<bool> kill_{false};
 
-    /// Pool of threads
+    /// Number of tasks pushed but not yet started, including tasks a worker has batched
+    std::atomic<size_t> pending_{0};
+
+    /// Number of tasks any idle worker could dequeue, across all queues
+    std::atomic<size_t> queued_{0};
+
+    /// Number of parked workers
+    std::atomic<size_t> idle_{0};
+
+    /// Per worker slots to park on while there is nothing to do
+    std::unique_ptr<parking_slot[]> slots_;
+
+    /// Indices of parked workers, protected by idle_lock_
+    std::mutex idle_lock_;
+    std::vector<size_t> parked_;
+
+    /// Pool of threads, one per worker index, only joinable while the worker is live or retiring
     std::vector<thread> threads_;
 
-    /// Lock, protects the queue and the condition variables
+    /// Protects vacant_
+    std::mutex resize_lock_;
+
+    /// Worker indices without a live worker
+    std::vector<size_t> vacant_;
+
+    /// Lock, protects the queue and the condition variable
     mutable std::mutex lock_;
 
-    /// Condition Variable
-    std::condition_variable q_push_notifier_;
+    /// Condition Variable, signalled when the last pending task is dequeued
     std::condition_variable q_pop_notifier_;
 
-    /// Queue of tasks to execute
-    std::queue<Task> q_;
+    /// Signalled when a task is dequeued while producers are blocked on a full queue
+    std::condition_variable q_space_notifier_;
+
+    /// Number of producers blocked on a full queue
+    std::atomic<size_t> blocked_{0};
+
+    /// Queue of tasks to execute per priority lane, in work stealing mode only holds tasks pushed from outside
+    /// the pool or with a non default priority
+    std::vector<std::deque<Task>> lanes_;
+
+    /// Replace lanes_ when the queue is lock free
+    std::vector<std::unique_ptr<mpmc_queue<Task>>> rings_;
+
+    /// Min heap of tasks with deadlines, only used for earliest deadline first dispatch
+    std::vector<DeadlineTask> deadlines_;
+
+    /// Number of tasks in the deadline heap
+    std::atomic<size_t> deadlines_size_{0};
+
+    /// Per worker deques, only used in work stealing mode
+    std::vector<std::unique_ptr<work_stealing_deque<Task *>>> deques_;
+
+    /// A periodic task, shared by every run
+    struct Periodic {
+        Task task;
+        /// A run is posted or running, the timer skips firings until it finishes
+        std::atomic<bool> in_flight{false};
+    };
+
+    /// A scheduled task waiting in the timer wheel
+    struct Timer {
+        /// One shot task, moved out when it expires
+        Task task{};
+        /// Periodic task, shared by every run
+        std::shared_ptr<Periodic> periodic{};
+        /// Ticks between runs
+        uint64_t period = 0;
+    };
+
+    /// Parameters for the timer thread
+    const thread::Params thread_params_;
+
+    /// Length of a timer wheel tick
+    const clock::duration timer_resolution_;
+
+    /// Time of tick 0
+    const clock::time_point timer_epoch_;
+
+    /// Protects the timer wheel
+    std::mutex timer_lock_;
+
+    /// Signalled when a timer is added or the pool is joined
+    std::condition_variable timer_notifier_;
+
+    /// Scheduled tasks
+    timer_wheel<Timer> timers_;
+
+    /// Posts expired timers and supervises an elastic pool's size, started by the first scheduled task or by the
+    /// constructor of an elastic pool
+    thread timer_thread_;
+
+    /// Applies the inline policy, then the overflow policy if the queue is full, blocking if the policy says so
+    Admission admit() noexcept;
+
+    /// Checks if the inline policy wants a pushed task to run on the calling thread
+    bool should_inline() const noexcept;
+
+    /// Runs a pushed task on the calling thread, tracking how deeply inline tasks are nested
+    void run_inline(Task &task) noexcept;
+
+    /// Removes the oldest evictable task from the lowest priority lane of the shared queue
+    /// \returns false if there is none
+    bool evict_oldest() noexcept;
+
+    /// Adds a task to the appropriate queue and wakes up a thread
+    void enqueue(Task &&task, const size_t level = 0) noexcept;
+
+    /// Adds a task to the deadline heap and wakes up a thread
+    void enqueue_deadline(Task &&task, const clock::time_point deadline) noexcept;
+
+    /// Pops the task with the earliest deadline
+    /// \returns false if the heap is empty
+    bool dequeue_deadline(Task &task) noexcept;
+
+    /// Adds all tasks to the appropriate queue at once and wakes up at most one thread per task
+    void enqueue_bulk(std::vector<Task> &&tasks) noexcept;
+
+    /// Waits for a full ring to drain, a worker of this pool runs a queued task itself since it may be the only
+    /// thread that could
+    void wait_for_ring(const size_t count) noexcept;
+
+    /// Dequeues a task for a worker, or for a thread outside the pool if index is kNotWorker
+    /// \returns false if there was nothing to dequeue
+    bool dequeue(const size_t index, Task &task) noexcept;
+
+    /// Dequeues a task from another worker's deque, index may be kNotWorker
+    bool steal(const size_t index, Task &task) noexcept;
+
+    /// Returns this worker's batched tasks to the front of their lane
+    void release_batch() noexcept;
+
+    /// Lane a worker should look at first, lanes are then visited in priority order
+    size_t first_lane() noexcept;
+
+    /// Pops a task from the lanes in dispatch order, the lock must be held in mutex mode
+    /// \returns the lane it came from, or nullopt if all lanes are empty
+    std::optional<size_t> pop_lane(Task &task) noexcept;
+
+    /// Counts tasks about to be published to a queue
+    void published(const size_t count) noexcept;
+
+    /// Bookkeeping after a task leaves a queue without the lock held
+    void on_dequeue() noexcept;
+
+    /// Unparks up to count workers after tasks were added, does nothing if no worker is parked
+    void notify_push(const size_t count = 1) noexcept;
+
+    /// Parks a worker until a task is pushed
+    /// \returns false if the worker idled past the keep alive and should retire
+    bool park(const size_t index) noexcept;
+
+    /// Claims a retirement, keeping at least size_ workers and honouring the cooldown
+    bool shrink() noexcept;
+
+    /// Spawns a worker if tasks have waited longer than the grow threshold, called periodically by the timer thread
+    void supervise() noexcept;
+
+    /// Tick of the timer wheel the current time falls in
+    uint64_t current_tick() const noexcept;
+
+    /// Adds a timer, a zero period means it runs once
+    timer_handle schedule(const clock::time_point when, const clock::duration period, Task &&task) noexcept;
+
+    /// Timer thread, advances the wheel and posts expired timers, and supervises an elastic pool
+    void timer_loop() noexcept;
 
     /// Cancels and joins all threads
     void join() noexcept;
 
     /// Worker thread, waits to dequeu tasks from the queue
-    void worker() noexcept;
+    void worker(const size_t index) noexcept;
 };
 
+namespace details {
+
+/// Lets the pool's own helpers queue continuations past the queue bound, a continuation that was dropped or ran on
+/// the wrong thread would leave whatever waits on it hanging
+struct pool_access {
+    /// Queues the task unconditionally, it must not throw
+    template <typename Callable, typename ... Args>
+    static void post(thread_pool &pool, Callable &&callable, Args && ... args) noexcept {
+        pool.enqueue(task(details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...)));
+    }
+};
+
+} // namespace details
+
 } // namespace tp
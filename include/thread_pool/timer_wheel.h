@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tp {
+
+/// Identifies a timer, stays valid until the timer expires for the last time or is cancelled
+struct timer_handle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+/// Hierarchical timer wheel, not thread safe
+/// Time is measured in ticks, insert and cancel are O(1) and advancing costs O(1) per tick plus the expired timers
+/// Each level has 256 slots, a timer lives on the lowest level whose span covers its remaining time and
+/// cascades down a level every time the level below wraps around
+template <typename T>
+class timer_wheel {
+  public:
+    using handle = timer_handle;
+
+    /// Number of pending timers
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    /// Current tick
+    uint64_t now() const noexcept {
+        return now_;
+    }
+
+    /// Earliest tick at which advance may have work to do, either an expiry or a cascade
+    uint64_t next_tick() const noexcept {
+        const auto wrap = (now_ | kSlotMask) + 1;
+        for (auto tick = now_ + 1; tick < wrap; tick++) {
+            if (slots_[0][slot_of(tick, 0)] != kNil) {
+                return tick;
+            }
+        }
+        return wrap;
+    }
+
+    /// Adds a timer, expiries in the past fire on the next tick
+    handle insert(const uint64_t expiry, T payload) {
+        uint32_t index = kNil;
+        if (free_ != kNil) {
+            index = free_;
+            free_ = nodes_[index].next;
+        } else {
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+
+        auto &node = nodes_[index];
+        node.payload = std::move(payload);
+        node.expiry = expiry;
+        link(index, now_ + 1);
+        size_++;
+
+        return handle{index, node.generation};
+    }
+
+    /// Removes a pending timer
+    /// \returns false if the timer already expired or was cancelled
+    bool cancel(const handle timer) noexcept {
+        if (timer.index >= nodes_.size()) {
+            return false;
+        }
+
+        auto &node = nodes_[timer.index];
+        if (!node.linked || node.generation != timer.generation) {
+            return false;
+        }
+
+        unlink(timer.index);
+        release(timer.index);
+        return true;
+    }
+
+    /// Advances to tick, calling on_expire(payload) for every timer that expires on the way
+    /// on_expire returns the next expiry to rearm the timer under the same handle, or nullopt to retire it,
+    /// it must not modify the wheel
+    template <typename OnExpire>
+    void advance(const uint64_t tick, OnExpire &&on_expire) {
+        while (now_ < tick) {
+            // Nothing can expire, jump straight there
+            if (size_ == 0) {
+                now_ = tick;
+                return;
+            }
+
+            now_++;
+
+            // Each time a level wraps, the next level's current slot moves down
+            for (size_t level = 1; level < kLevels; level++) {
+                if (slot_of(now_, level - 1) != 0) {
+                    break;
+                }
+                relink_slot(level, slot_of(now_, level));
+            }
+
+            // Everything left in the current bottom slot is due, timers clamped to the top level are relinked
+            auto index = std::exchange(slots_[0][slot_of(now_, 0)], kNil);
+            while (index != kNil) {
+                const auto next = nodes_[index].next;
+                nodes_[index].linked = false;
+
+                if (nodes_[index].expiry > now_) {
+                    link(index, now_ + 1);
+                } else if (const auto rearm = on_expire(nodes_[index].payload); rearm.has_value()) {
+                    nodes_[index].expiry = rearm.value();
+                    link(index, now_ + 1);
+                } else {
+                    release(index);
+                }
+
+                index = next;
+            }
+        }
+    }
+
+  private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+    static constexpr size_t kLevels = 4;
+    static constexpr size_t kSlotBits = 8;
+    static constexpr size_t kSlots = 1 << kSlotBits;
+    static constexpr uint64_t kSlotMask = kSlots - 1;
+
+    struct Node {
+        T payload{};
+        uint64_t expiry = 0;
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t generation = 0;
+        uint8_t level = 0;
+        uint8_t slot = 0;
+        bool linked = false;
+    };
+
+    /// Timers, free ones are chained through next
+    std::vector<Node> nodes_;
+    uint32_t free_ = kNil;
+
+    /// Head of the list of timers in each slot
+    std::array<std::array<uint32_t, kSlots>, kLevels> slots_ = make_slots();
+
+    uint64_t now_ = 0;
+    size_t size_ = 0;
+
+    static std::array<std::array<uint32_t, kSlots>, kLevels> make_slots() noexcept {
+        std::array<std::array<uint32_t, kSlots>, kLevels> slots{};
+        for (auto &level : slots) {
+            level.fill(kNil);
+        }
+        return slots;
+    }
+
+    static size_t slot_of(const uint64_t tick, const size_t level) noexcept {
+        return static_cast<size_t>((tick >> (level * kSlotBits)) & kSlotMask);
+    }
+
+    /// Places a timer on the lowest level whose span covers it, no earlier than the earliest tick
+    void link(const uint32_t index, const uint64_t earliest) noexcept {
+        auto &node = nodes_[index];
+
+        // Timers beyond the top level wait at its far end and are relinked from there
+        constexpr uint64_t kMaxDelta = (uint64_t{1} << (kLevels * kSlotBits)) - 1;
+        const auto expiry = std::clamp(node.expiry, earliest, now_ + kMaxDelta);
+
+        size_t level = 0;
+        while (level + 1 < kLevels && (expiry - now_) >= (uint64_t{1} << ((level + 1) * kSlotBits))) {
+            level++;
+        }
+
+        const auto slot = slot_of(expiry, level);
+        auto &head = slots_[level][slot];
+        node.level = static_cast<uint8_t>(level);
+        node.slot = static_cast<uint8_t>(slot);
+        node.prev = kNil;
+        node.next = head;
+        if (head != kNil) {
+            nodes_[head].prev = index;
+        }
+        head = index;
+        node.linked = true;
+    }
+
+    void unlink(const uint32_t index) noexcept {
+        auto &node = nodes_[index];
+        if (node.prev != kNil) {
+            nodes_[node.prev].next = node.next;
+        } else {
+            slots_[node.level][node.slot] = node.next;
+        }
+        if (node.next != kNil) {
+            nodes_[node.next].prev = node.prev;
+        }
+        node.linked = false;
+    }
+
+    /// Returns a timer to the free list and invalidates its handles
+    void release(const uint32_t index) noexcept {
+        auto &node = nodes_[index];
+        node.payload = T{};
+        node.generation++;
+        node.next = free_;
+        free_ = index;
+        size_--;
+    }
+
+    /// Moves every timer in a slot to wherever it belongs now, timers due this tick land in the bottom slot about to run
+    void relink_slot(const size_t level, const size_t slot) noexcept {
+        auto index = std::exchange(slots_[level][slot], kNil);
+        while (index != kNil) {
+            const auto next = nodes_[index].next;
+            nodes_[index].linked = false;
+            link(index, now_);
+            index = next;
+        }
+    }
+};
+
+} // namespace tp
@@ -25,9 +25,10 @@ auto transform_tuple_strip_first(const Tuple &tuple) {
     return transform_tuple_strip_first(tuple, std::make_index_sequence<kSize - 1>());
 }
 
-/// Set up thread with the callable and arguments
+/// Binds the callable and arguments into a lambda taking no arguments, without type erasure
+/// The lambda returns whatever the callable returns
 template <typename Callable, typename ... Args>
-std::function<void()> construct(Callable &&callable, Args && ... args) noexcept {
+auto bind(Callable &&callable, Args && ... args) noexcept {
     constexpr bool kIsFreeFunction = !std::is_member_function_pointer_v<Callable>;
     constexpr auto kSize = sizeof...(args);
     static_assert(kIsFreeFunction || kSize > 0, "If member function, object must be an arg");
@@ -35,8 +36,8 @@ std::function<void()> construct(Callable &&callable, Args && ... args) noexcept
     if constexpr (kIsFreeFunction) {
         return [callable = std::forward<Callable>(callable),
                 args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
-            std::apply([&](auto && ... args) {
-                callable(std::forward<Args>(args)...);
+            return std::apply([&](auto && ... args) {
+                return callable(std::forward<Args>(args)...);
             }, std::move(args));
         };
     } else {
@@ -50,11 +51,17 @@ std::function<void()> construct(Callable &&callable, Args && ... args) noexcept
         return [object,
                 callable = std::forward<Callable>(callable),
                 args = std::move(arg_tuple)] {
-            std::apply([&](auto && ... args) {
-                std::mem_fn(callable)(object, std::forward<decltype(args)>(args)...);
+            return std::apply([&](auto && ... args) {
+                return std::mem_fn(callable)(object, std::forward<decltype(args)>(args)...);
             }, std::move(args));
         };
     }
 }
 
+/// Set up thread with the callable and arguments
+template <typename Callable, typename ... Args>
+std::function<void()> construct(Callable &&callable, Args && ... args) noexcept {
+    return details::bind(std::forward<Callable>(callable), std::forward<Args>(args)...);
+}
+
 } // namespace tp::details
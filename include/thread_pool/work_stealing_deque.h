@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace tp {
+
+/// Chase-Lev work stealing deque
+/// The owner pushes and pops from the bottom, any other thread may steal from the top
+/// Based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013)
+template <typename T>
+class work_stealing_deque {
+    static_assert(std::is_pointer_v<T>, "Elements are published atomically, must be pointers");
+
+  public:
+    /// Constructor, capacity is rounded up to a power of 2
+    explicit work_stealing_deque(const size_t capacity = 64) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+
+        arrays_.push_back(std::make_unique<Array>(rounded));
+        array_ = arrays_.back().get();
+    }
+
+    /// Non movable
+    work_stealing_deque(work_stealing_deque &&other) = delete;
+    work_stealing_deque &operator=(work_stealing_deque &&other) = delete;
+
+    /// Non copyable
+    work_stealing_deque(const work_stealing_deque &other) = delete;
+    work_stealing_deque &operator=(const work_stealing_deque &other) = delete;
+
+    /// Push to the bottom, only the owner may call this
+    void push(T element) {
+        const auto bottom = bottom_.load(std::memory_order_relaxed);
+        const auto top = top_.load(std::memory_order_acquire);
+        auto *array = array_.load(std::memory_order_relaxed);
+
+        if (bottom - top > static_cast<int64_t>(array->capacity) - 1) {
+            array = grow(array, bottom, top);
+        }
+
+        array->put(bottom, element);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /// Pop from the bottom, only the owner may call this
+    /// \returns nullptr if empty
+    T pop() {
+        const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        auto *array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = top_.load(std::memory_order_relaxed);
+
+        // Empty
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto element = array->get(bottom);
+
+        // Last element, race against thieves for it
+        if (top == bottom) {
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                element = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return element;
+    }
+
+    /// Steal from the top, any thread may call this
+    /// \returns nullptr if empty or if another thread won the race
+    T steal() {
+        auto top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        auto *array = array_.load(std::memory_order_acquire);
+        auto element = array->get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+
+        return element;
+    }
+
+    /// Approximate number of elements
+    size_t size() const noexcept {
+        const auto bottom = bottom_.load(std::memory_order_relaxed);
+        const auto top = top_.load(std::memory_order_relaxed);
+        return (bottom > top) ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    /// Approximately empty
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+  private:
+    /// Circular array of atomic slots
+    struct Array {
+        explicit Array(const size_t capacity)
+            : capacity(capacity), mask(capacity - 1), slots(std::make_unique<std::atomic<T>[]>(capacity)) {}
+
+        void put(const int64_t index, T element) noexcept {
+            slots[static_cast<size_t>(index) & mask].store(element, std::memory_order_relaxed);
+        }
+
+        T get(const int64_t index) const noexcept {
+            return slots[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed);
+        }
+
+        const size_t capacity;
+        const size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    /// Index of the next element to steal
+    alignas(64) std::atomic<int64_t> top_{0};
+
+    /// Index of the next slot to push to
+    alignas(64) std::atomic<int64_t> bottom_{0};
+
+    /// Current array
+    alignas(64) std::atomic<Array *> array_{nullptr};
+
+    /// All arrays ever allocated, thieves may still be reading retired arrays so they live until destruction
+    std::vector<std::unique_ptr<Array>> arrays_;
+
+    /// Doubles the capacity, only the owner may call this
+    Array *grow(Array *array, const int64_t bottom, const int64_t top) {
+        arrays_.push_back(std::make_unique<Array>(array->capacity * 2));
+        auto *bigger = arrays_.back().get();
+        for (auto ii = top; ii < bottom; ii++) {
+            bigger->put(ii, array->get(ii));
+        }
+
+        array_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+};
+
+} // namespace tp
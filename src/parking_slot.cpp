@@ -0,0 +1,55 @@
+#include "thread_pool/parking_slot.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <ctime>
+
+namespace tp {
+
+namespace {
+
+/// Sleeps while the word equals expected, spurious returns are possible
+void futex_wait(std::atomic<uint32_t> &word, const uint32_t expected, const timespec *timeout) noexcept {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t> &word) noexcept {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+} // namespace
+
+void parking_slot::park() noexcept {
+    while (state_.exchange(kEmpty, std::memory_order_acquire) != kNotified) {
+        futex_wait(state_, kEmpty, nullptr);
+    }
+}
+
+bool parking_slot::park_for(const std::chrono::nanoseconds timeout) noexcept {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (state_.exchange(kEmpty, std::memory_order_acquire) != kNotified) {
+        const auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::nanoseconds(0)) {
+            return false;
+        }
+
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+        const timespec relative{
+            static_cast<time_t>(seconds.count()),
+            static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count()),
+        };
+        futex_wait(state_, kEmpty, &relative);
+    }
+
+    return true;
+}
+
+void parking_slot::unpark() noexcept {
+    if (state_.exchange(kNotified, std::memory_order_release) == kEmpty) {
+        futex_wake(state_);
+    }
+}
+
+} // namespace tp
@@ -0,0 +1,210 @@
+#include "thread_pool/pipeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+
+namespace tp {
+
+/// State of one run, lives on the stack of run()
+struct pipeline::Run {
+    /// An item in flight
+    struct Item {
+        size_t sequence;
+        Value value;
+    };
+
+    /// Bookkeeping of a serial stage
+    struct Serial {
+        std::mutex lock;
+        /// An item is being processed
+        bool busy = false;
+        /// Sequence the next in order item must have
+        size_t next = 0;
+        /// Items waiting for their turn, by sequence
+        std::map<size_t, Item *> ordered;
+        /// Items waiting for the stage to be free
+        std::deque<Item *> unordered;
+    };
+
+    Run(pipeline &owner, thread_pool &pool, const size_t max_tokens)
+        : owner(owner), pool(pool), max_tokens(std::max<size_t>(max_tokens, 1)),
+          serial(std::make_unique<Serial[]>(owner.stages_.size())) {}
+
+    pipeline &owner;
+    thread_pool &pool;
+    const size_t max_tokens;
+    std::unique_ptr<Serial[]> serial;
+
+    /// Items taken from the source and not yet finished, only the pumping thread adds to it
+    std::atomic<size_t> tokens{0};
+
+    /// Items started and not yet done touching this run, the run ends when it drops to 0 after the source is done
+    std::atomic<size_t> active{0};
+
+    /// Pump requests, the thread which raises it from 0 pumps on behalf of everyone who asks while it does
+    std::atomic<size_t> pump_requests{0};
+
+    /// Sequence of the next item from the source, only touched by the pumping thread
+    size_t sequence = 0;
+
+    /// The source returned nullopt or the run failed
+    std::atomic<bool> exhausted{false};
+
+    /// A stage or the source threw
+    std::atomic<bool> failed{false};
+
+    /// Protects exception and the end of the run
+    std::mutex lock;
+    std::condition_variable done;
+    std::exception_ptr exception;
+
+    /// Records the first exception and stops the source
+    void fail(std::exception_ptr error) noexcept {
+        std::scoped_lock guard(lock);
+        if (!failed.exchange(true)) {
+            exception = std::move(error);
+        }
+    }
+
+    /// Pulls items from the source while tokens are free
+    void pump() noexcept {
+        if (pump_requests.fetch_add(1) > 0) {
+            return;
+        }
+
+        size_t handled = 0;
+        do {
+            handled = pump_requests.load();
+            while (!exhausted && !failed && tokens < max_tokens) {
+                std::optional<Value> value;
+                try {
+                    value = owner.source_->next();
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+
+                if (!value.has_value()) {
+                    std::scoped_lock guard(lock);
+                    exhausted = true;
+                    break;
+                }
+
+                tokens++;
+                active++;
+                auto *item = new Item{sequence++, std::move(value.value())};
+                details::pool_access::post(pool, [this, item] { advance(item, 0, false); });
+            }
+        } while (pump_requests.fetch_sub(handled) != handled);
+    }
+
+    /// Moves an item through the stages starting at stage, claimed if it already owns that serial stage
+    void advance(Item *item, size_t stage, bool claimed) noexcept {
+        for (; stage < owner.stages_.size(); stage++, claimed = false) {
+            auto &current = owner.stages_[stage];
+            const bool is_serial = (current.mode != Mode::kParallel);
+
+            // Wait at a serial stage which is busy or, if in order, not yet at this item
+            if (is_serial && !claimed) {
+                auto &state = serial[stage];
+                std::scoped_lock guard(state.lock);
+                if (current.mode == Mode::kSerialInOrder && (state.busy || item->sequence != state.next)) {
+                    state.ordered.emplace(item->sequence, item);
+                    return;
+                }
+                if (current.mode == Mode::kSerialOutOfOrder && state.busy) {
+                    state.unordered.push_back(item);
+                    return;
+                }
+                state.busy = true;
+            }
+
+            // After a failure items still pass through serial stages so in order stages see every sequence
+            if (!failed) {
+                try {
+                    item->value = current.function->process(std::move(item->value));
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+            }
+
+            if (is_serial) {
+                release(stage);
+            }
+        }
+
+        finish(item);
+    }
+
+    /// Frees a serial stage and hands it to the next waiting item
+    void release(const size_t stage) noexcept {
+        auto &state = serial[stage];
+        Item *resume = nullptr;
+        {
+            std::scoped_lock guard(state.lock);
+            state.busy = false;
+            state.next++;
+
+            if (owner.stages_[stage].mode == Mode::kSerialInOrder) {
+                const auto it = state.ordered.find(state.next);
+                if (it != state.ordered.end()) {
+                    resume = it->second;
+                    state.ordered.erase(it);
+                }
+            } else if (!state.unordered.empty()) {
+                resume = state.unordered.front();
+                state.unordered.pop_front();
+            }
+
+            state.busy = (resume != nullptr);
+        }
+
+        if (resume != nullptr) {
+            details::pool_access::post(pool, [this, resume, stage] { advance(resume, stage, true); });
+        }
+    }
+
+    /// Frees the item's token and lets the source refill it
+    void finish(Item *item) noexcept {
+        delete item;
+        tokens--;
+        pump();
+
+        // Last, once this is 0 after the source is done run() may return
+        std::scoped_lock guard(lock);
+        if (--active == 0 && (exhausted || failed)) {
+            done.notify_all();
+        }
+    }
+};
+
+void pipeline::run(thread_pool &pool, const size_t max_tokens) {
+    // How long to block before looking for work again
+    constexpr auto kRecheckPeriod = std::chrono::microseconds(100);
+
+    Run state(*this, pool, max_tokens);
+    state.pump();
+
+    auto finished = [&state] { return state.active == 0 && (state.exhausted || state.failed); };
+    while (true) {
+        if (state.active > 0 && pool.run_pending_task()) {
+            continue;
+        }
+
+        std::unique_lock lock(state.lock);
+        if (state.done.wait_for(lock, kRecheckPeriod, finished)) {
+            break;
+        }
+    }
+
+    if (state.exception != nullptr) {
+        std::rethrow_exception(state.exception);
+    }
+}
+
+} // namespace tp
@@ -0,0 +1,62 @@
+#include "thread_pool/strand.h"
+
+namespace tp::details {
+
+namespace {
+
+/// Tasks a drain runs before going to the back of the pool's queue, so one busy strand cannot hog a worker
+constexpr size_t kDrainBudget = 64;
+
+/// Pops the next task, or marks the queue idle if there is none
+/// \returns false if the queue went idle
+bool serial_pop(serial_queue &queue, task &work) noexcept {
+    std::scoped_lock lock(queue.lock);
+    if (queue.tasks.empty()) {
+        queue.scheduled = false;
+        return false;
+    }
+
+    work = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
+
+void serial_drain(const std::shared_ptr<serial_queue> &queue) noexcept {
+    for (size_t ii = 0; ii < kDrainBudget; ii++) {
+        task work{};
+        if (!serial_pop(*queue, work)) {
+            queue->on_idle();
+            return;
+        }
+
+        work();
+    }
+
+    // Out of budget, this drain still owns the queue so it either continues later or goes idle
+    {
+        std::scoped_lock lock(queue->lock);
+        if (!queue->tasks.empty()) {
+            details::pool_access::post(queue->pool, serial_drain, queue);
+            return;
+        }
+        queue->scheduled = false;
+    }
+
+    queue->on_idle();
+}
+
+} // namespace
+
+void serial_post(const std::shared_ptr<serial_queue> &queue, task &&work) noexcept {
+    {
+        std::scoped_lock lock(queue->lock);
+        queue->tasks.push_back(std::move(work));
+        if (std::exchange(queue->scheduled, true)) {
+            return;
+        }
+    }
+
+    details::pool_access::post(queue->pool, serial_drain, queue);
+}
+
+} // namespace tp::details
@@ -0,0 +1,142 @@
+#include "thread_pool/task_graph.h"
+
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+
+namespace tp {
+
+void task_graph::depends_on(const node successor, const node predecessor) {
+    if (successor >= nodes_.size() || predecessor >= nodes_.size()) {
+        throw std::out_of_range("task_graph node does not exist");
+    }
+
+    nodes_[predecessor].successors.push_back(successor);
+    nodes_[successor].predecessors++;
+    validated_ = false;
+}
+
+size_t task_graph::size() const noexcept {
+    return nodes_.size();
+}
+
+void task_graph::run(thread_pool &pool) {
+    // How long to block before looking for work again
+    constexpr auto kRecheckPeriod = std::chrono::microseconds(100);
+
+    if (!validated_) {
+        validate();
+    }
+    if (nodes_.empty()) {
+        return;
+    }
+
+    pool_ = &pool;
+    failed_ = false;
+    exception_ = nullptr;
+    for (size_t ii = 0; ii < nodes_.size(); ii++) {
+        remaining_[ii].store(nodes_[ii].predecessors, std::memory_order_relaxed);
+    }
+    unfinished_ = nodes_.size();
+
+    for (const auto root : roots_) {
+        details::pool_access::post(pool, [this, root] { execute(root); });
+    }
+
+    // Help until the last node finishes, the final check is under the lock the last node signals under
+    while (true) {
+        if (unfinished_ > 0 && pool.run_pending_task()) {
+            continue;
+        }
+
+        std::unique_lock lock(completion_->lock);
+        if (completion_->done.wait_for(lock, kRecheckPeriod, [this] { return unfinished_ == 0; })) {
+            break;
+        }
+    }
+
+    if (exception_ != nullptr) {
+        std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+}
+
+void task_graph::validate() {
+    // Kahn's algorithm, every node must become ready exactly once
+    std::vector<size_t> in_degree(nodes_.size());
+    std::vector<node> ready;
+    roots_.clear();
+    for (size_t ii = 0; ii < nodes_.size(); ii++) {
+        in_degree[ii] = nodes_[ii].predecessors;
+        if (in_degree[ii] == 0) {
+            roots_.push_back(ii);
+            ready.push_back(ii);
+        }
+    }
+
+    size_t visited = 0;
+    while (!ready.empty()) {
+        const auto current = ready.back();
+        ready.pop_back();
+        visited++;
+        for (const auto successor : nodes_[current].successors) {
+            if (--in_degree[successor] == 0) {
+                ready.push_back(successor);
+            }
+        }
+    }
+
+    if (visited != nodes_.size()) {
+        throw std::invalid_argument("task_graph has a cycle");
+    }
+
+    remaining_ = std::make_unique<std::atomic<size_t>[]>(nodes_.size());
+    if (completion_ == nullptr) {
+        completion_ = std::make_shared<Completion>();
+    }
+    validated_ = true;
+}
+
+void task_graph::execute(node index) noexcept {
+    // Once the last node is counted run() may return and the graph go away, so signalling must not touch it
+    // One reference per chain of nodes rather than per node keeps the counting off the per node path
+    const auto completion = completion_;
+
+    while (true) {
+        auto &current = nodes_[index];
+        if (!failed_.load(std::memory_order_relaxed)) {
+            try {
+                current.work();
+            } catch (...) {
+                std::scoped_lock lock(lock_);
+                if (!failed_.exchange(true)) {
+                    exception_ = std::current_exception();
+                }
+            }
+        }
+
+        // Push every successor this made ready but the last, which this thread runs next without a round trip
+        std::optional<node> next;
+        for (const auto successor : current.successors) {
+            if (remaining_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (next.has_value()) {
+                    details::pool_access::post(*pool_, [this, ready = next.value()] { execute(ready); });
+                }
+                next = successor;
+            }
+        }
+
+        // Only the last node locks, after the decrement so a run() checking under the lock cannot miss it
+        if (unfinished_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::scoped_lock lock(completion->lock);
+            completion->done.notify_all();
+            return;
+        }
+
+        if (!next.has_value()) {
+            return;
+        }
+        index = next.value();
+    }
+}
+
+} // namespace tp
@@ -0,0 +1,55 @@
+#include "thread_pool/task_group.h"
+
+#include <chrono>
+
+namespace tp {
+
+task_group::task_group(thread_pool &pool) noexcept : pool_(pool), state_(std::make_shared<State>()) {}
+
+task_group::~task_group() noexcept {
+    help();
+}
+
+void task_group::wait() {
+    help();
+
+    std::exception_ptr exception;
+    {
+        std::scoped_lock lock(state_->lock);
+        exception = std::exchange(state_->exception, nullptr);
+    }
+
+    if (exception != nullptr) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void task_group::help() noexcept {
+    // How long to block before looking for work again, remaining tasks are already running and may spawn more
+    constexpr auto kRecheckPeriod = std::chrono::microseconds(100);
+
+    while (state_->pending > 0) {
+        if (pool_.run_pending_task()) {
+            continue;
+        }
+
+        std::unique_lock lock(state_->lock);
+        state_->done.wait_for(lock, kRecheckPeriod, [this] { return state_->pending == 0; });
+    }
+}
+
+void task_group::State::fail(std::exception_ptr thrown) noexcept {
+    std::scoped_lock guard(lock);
+    if (exception == nullptr) {
+        exception = std::move(thrown);
+    }
+}
+
+void task_group::State::finish() noexcept {
+    if (--pending == 0) {
+        std::scoped_lock guard(lock);
+        done.notify_all();
+    }
+}
+
+} // namespace tp
@@ -9,38 +9,16 @@
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <optional>
 #include <string>
 
 namespace tp {
 
-/// An atomic optional integral type
-class thread::Id {
-  public:
-    Id &operator=(const size_t value) {
-        std::scoped_lock lock(lock_);
-        value_ = value;
-        return *this;
+void thread::ThreadParams::Release::operator()(ThreadParams *params) const noexcept {
+    if (params->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete params;
     }
-
-    size_t value() const {
-        std::scoped_lock lock(lock_);
-        return value_.value();
-    }
-
-    bool has_value() noexcept {
-        std::scoped_lock lock(lock_);
-        return value_.has_value();
-    }
-
-    void reset() noexcept {
-        std::scoped_lock lock(lock_);
-        value_.reset();
-    }
-
-  private:
-    mutable std::mutex lock_;
-    std::optional<size_t> value_{};
-};
+}
 
 size_t thread::hardware_concurrency() {
     std::ifstream cpuinfo("/proc/cpuinfo");
@@ -52,14 +30,12 @@ size_t thread::hardware_concurrency() {
 
 thread::thread(thread &&other) noexcept
     : handle_(std::move(other.handle_))
-    , id_(std::move(other.id_))
     , thread_params_(std::move(other.thread_params_)) {
     other.handle_.reset();
 }
 
 thread &thread::operator=(thread &&other) noexcept {
     handle_ = std::move(other.handle_);
-    id_ = std::move(other.id_);
     thread_params_ = std::move(other.thread_params_);
     other.handle_.reset();
     return *this;
@@ -76,7 +52,12 @@ bool thread::joinable() const noexcept {
 }
 
 size_t thread::get_id() const {
-    return id_->value();
+    const auto id = (thread_params_ && joinable()) ? thread_params_->id.load(std::memory_order_acquire) : 0;
+    if (0 == id) {
+        throw std::bad_optional_access();
+    }
+
+    return id;
 }
 
 size_t thread::native_handle() const {
@@ -104,7 +85,7 @@ void thread::join() noexcept {
     }
 
     handle_.reset();
-    id_->reset();
+    thread_params_.reset();
 }
 
 void thread::detach() noexcept {
@@ -125,7 +106,7 @@ void thread::detach() noexcept {
     }
 
     handle_.reset();
-    id_->reset();
+    thread_params_.reset();
 }
 
 void thread::create(const Params &params) noexcept {
@@ -136,13 +117,15 @@ void thread::create(const Params &params) noexcept {
         pthread_attr_setstacksize(&attributes, params.stack_size.value());
     }
 
-    // Iniitalize ID
-    id_ = std::make_shared<Id>();
-    thread_params_->store_id_callback = [id_ = id_](const size_t id) { *id_ = id; };
+    // The thread holds its own reference
+    thread_params_->references.fetch_add(1, std::memory_order_relaxed);
 
     // Create thread
     pthread_t handle{};
-    const auto error = pthread_create(&handle, &attributes, &thread::thread_wrapper, thread_params_.release());
+    const auto error = pthread_create(&handle, &attributes, &thread::thread_wrapper, thread_params_.get());
+    if (0 != error) {
+        thread_params_->references.fetch_sub(1, std::memory_order_relaxed);
+    }
     if (print_errors_) {
         switch (error) {
         case EAGAIN:
@@ -167,11 +150,14 @@ void thread::create(const Params &params) noexcept {
 
 void *thread::thread_wrapper(void *args) {
     const auto thread_id = syscall(__NR_gettid);
-    auto params = std::unique_ptr<ThreadParams>(static_cast<ThreadParams *>(args));
+    auto params = ThreadParamsPtr(static_cast<ThreadParams *>(args));
 
-    params->store_id_callback(thread_id);
+    params->id.store(static_cast<size_t>(thread_id), std::memory_order_release);
     params->run_callback();
 
+    // Release captures now rather than when the last owner lets go
+    params->run_callback = nullptr;
+
     return nullptr;
 }
 
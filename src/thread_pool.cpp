@@ -1,80 +1,849 @@
 #include "thread_pool/thread_pool.h"
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <thread>
+
 namespace tp {
 
-thread_pool::thread_pool(const Params &params) noexcept {
-    for (size_t t = 0; t < params.size; t++) {
-        threads_.push_back(thread(params.thread_params, &thread_pool::worker, this));
+namespace {
+
+/// The pool and index of the worker running on this thread, if any
+thread_local const thread_pool *tls_pool = nullptr;
+thread_local size_t tls_index = 0;
+
+/// Tasks a worker dequeued in a batch but has not run yet, and the lane they came from
+thread_local std::deque<task> tls_batch;
+thread_local size_t tls_batch_lane = 0;
+
+/// Moving average of how long this worker waits for a task
+thread_local std::chrono::nanoseconds tls_average_idle{0};
+
+/// Number of pushed tasks running inline on this thread's stack
+thread_local size_t tls_inline_depth = 0;
+
+/// Hint to the processor that this is a spin loop
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // namespace
+
+thread_pool::thread_pool(const Params &params) noexcept
+    : size_(params.size)
+    , capacity_(std::max(params.size, params.max_size))
+    , grow_threshold_(params.grow_threshold)
+    , keep_alive_(params.keep_alive)
+    , resize_cooldown_(params.resize_cooldown)
+    , scheduler_(params.scheduler)
+    , batch_size_(std::max<size_t>(params.batch_size, 1))
+    , max_queue_size_(params.max_queue_size)
+    , overflow_(params.overflow)
+    , inline_from_worker_(params.inline_from_worker)
+    , inline_queue_depth_(params.inline_queue_depth)
+    , inline_wait_(params.inline_wait)
+    , max_inline_depth_(params.max_inline_depth)
+    , inline_policy_(params.inline_from_worker || params.inline_queue_depth > 0 || params.inline_wait.has_value())
+    , dispatch_(params.dispatch)
+    , earliest_deadline_first_(params.earliest_deadline_first)
+    , wait_policy_(params.wait_policy)
+    , spin_count_(params.spin_count)
+    , adaptive_threshold_(params.adaptive_threshold)
+    , thread_params_(params.thread_params)
+    , timer_resolution_(std::max<clock::duration>(params.timer_resolution, std::chrono::nanoseconds(1)))
+    , timer_epoch_(clock::now()) {
+    const auto levels = std::max<size_t>(params.priority_levels, 1);
+    for (size_t lane = 0; lane < levels; lane++) {
+        const auto weight = (lane < params.priority_weights.size()) ? params.priority_weights[lane]
+                                                                     : (size_t{1} << (levels - 1 - lane));
+        const auto previous = cumulative_weights_.empty() ? 0 : cumulative_weights_.back();
+        cumulative_weights_.push_back(previous + std::max<size_t>(weight, 1));
+
+        if (params.queue == Queue::kLockFree) {
+            rings_.push_back(std::make_unique<mpmc_queue<Task>>(params.queue_capacity));
+        } else {
+            lanes_.emplace_back();
+        }
+    }
+
+    // Sized for the largest the pool can grow to, so nothing is reallocated while workers use it
+    slots_ = std::make_unique<parking_slot[]>(capacity_);
+    parked_.reserve(capacity_);
+
+    if (scheduler_ == Scheduler::kWorkStealing) {
+        for (size_t t = 0; t < capacity_; t++) {
+            deques_.push_back(std::make_unique<work_stealing_deque<Task *>>());
+        }
+    }
+
+    live_ = size_;
+    threads_.resize(capacity_);
+    for (size_t t = 0; t < size_; t++) {
+        threads_[t] = thread(params.thread_params, &thread_pool::worker, this, t);
+    }
+
+    // The timer thread watches how long tasks wait
+    if (capacity_ > size_) {
+        for (size_t t = capacity_; t-- > size_;) {
+            vacant_.push_back(t);
+        }
+
+        wait_mark_time_ = clock::now();
+        timer_thread_ = thread(thread_params_, &thread_pool::timer_loop, this);
     }
 }
 
 thread_pool::~thread_pool() noexcept {
     join();
+
+    // Abandoned tasks are destroyed here rather than along with the queues, a task breaking its future on destruction
+    // may post the future's continuation back to this pool, which is then dropped by the same loop
+    {
+        auto timers = std::exchange(timers_, timer_wheel<Timer>{});
+    }
+    Task task{};
+    while (dequeue(kNotWorker, task)) {
+        task.reset();
+    }
 }
 
 void thread_pool::join(const bool finish_queue) noexcept {
     // Block until queue is empty
     if (finish_queue) {
         std::unique_lock lock(lock_);
-        if (!q_.empty()) {
-            q_pop_notifier_.wait(lock, [this] { return q_.empty(); });
+        if (pending_ > 0) {
+            q_pop_notifier_.wait(lock, [this] { return pending_ == 0; });
         }
     }
 
     join();
 }
 
+bool thread_pool::cancel(const timer_handle timer) noexcept {
+    std::scoped_lock lock(timer_lock_);
+    return timers_.cancel(timer);
+}
+
+std::optional<size_t> thread_pool::worker_index() const noexcept {
+    if (tls_pool != this) {
+        return std::nullopt;
+    }
+    return tls_index;
+}
+
+bool thread_pool::run_pending_task() noexcept {
+    Task task{};
+    if (!dequeue((tls_pool == this) ? tls_index : kNotWorker, task)) {
+        return false;
+    }
+
+    task();
+    return true;
+}
+
 size_t thread_pool::size() const noexcept {
-    return threads_.size();
+    return live_;
+}
+
+size_t thread_pool::max_size() const noexcept {
+    return capacity_;
 }
 
 size_t thread_pool::qsize() const noexcept {
+    return pending_;
+}
+
+thread_pool::Admission thread_pool::admit() noexcept {
+    if (inline_policy_ && tls_inline_depth < max_inline_depth_ && should_inline()) {
+        return Admission::kInline;
+    }
+
+    if (!full()) {
+        return Admission::kQueue;
+    }
+
+    // Past the inline depth the task is queued over the bound rather than overflowing the stack
+    const bool can_inline = (tls_inline_depth < max_inline_depth_);
+
+    switch (overflow_) {
+    case Overflow::kBlock: {
+        // A worker waiting for its own pool to drain may be the one that has to drain it
+        if (tls_pool == this) {
+            return can_inline ? Admission::kInline : Admission::kQueue;
+        }
+
+        // Announce before checking so a worker dequeuing in between either is seen or sees this producer
+        std::unique_lock lock(lock_);
+        blocked_++;
+        q_space_notifier_.wait(lock, [this] { return !full() || kill_; });
+        blocked_--;
+        return Admission::kQueue;
+    }
+    case Overflow::kReject:
+        return Admission::kReject;
+    case Overflow::kDropOldest:
+        return evict_oldest() ? Admission::kQueue : Admission::kReject;
+    case Overflow::kCallerRuns:
+        return can_inline ? Admission::kInline : Admission::kQueue;
+    }
+
+    return Admission::kQueue;
+}
+
+bool thread_pool::should_inline() const noexcept {
+    if (inline_from_worker_ && tls_pool == this) {
+        return true;
+    }
+
+    const size_t pending = pending_;
+    if (inline_queue_depth_ > 0 && pending >= inline_queue_depth_) {
+        return true;
+    }
+
+    // Every queued task ahead of this one has to run first, spread over the workers
+    if (inline_wait_.has_value()) {
+        const auto average = std::chrono::nanoseconds(average_task_ns_.load(std::memory_order_relaxed));
+        const auto workers = static_cast<int64_t>(std::max<size_t>(live_, 1));
+        return average * static_cast<int64_t>(pending) / workers > inline_wait_.value();
+    }
+
+    return false;
+}
+
+void thread_pool::run_inline(Task &task) noexcept {
+    tls_inline_depth++;
+    task();
+    tls_inline_depth--;
+}
+
+bool thread_pool::evict_oldest() noexcept {
+    // Destroyed after the lock is released, which breaks its future
+    Task evicted{};
+
+    // The rings can only pop their oldest task, which may be a helper's continuation
+    if (!rings_.empty()) {
+        return false;
+    }
+
     std::scoped_lock lock(lock_);
-    return q_.size();
+    for (size_t lane = lanes_.size(); lane-- > 0;) {
+        auto &queue = lanes_[lane];
+        const auto it = std::find_if(queue.begin(), queue.end(),
+                                     [](Task &task) { return task.target<Evictable>() != nullptr; });
+        if (it != queue.end()) {
+            evicted = std::move(*it);
+            queue.erase(it);
+            queued_--;
+            if (--pending_ == 0) {
+                q_pop_notifier_.notify_one();
+            }
+            return true;
+        }
+    }
+
+    // Only continuations or tasks in the workers' deques or the deadline heap are waiting
+    return false;
 }
 
-void thread_pool::join() noexcept {
-    kill_ = true;
-    q_push_notifier_.notify_all();
-    for (auto &thread : threads_) {
-        thread.join();
+void thread_pool::enqueue(Task &&task, const size_t level) noexcept {
+    const auto lane = std::min(level, cumulative_weights_.size() - 1);
+
+    // Default priority tasks pushed from one of this pool's workers stay on that worker's deque
+    if (scheduler_ == Scheduler::kWorkStealing && tls_pool == this && lane == 0) {
+        // Count before publishing so a thief can never observe the task before it is counted
+        published(1);
+        deques_[tls_index]->push(new Task(std::move(task)));
+        notify_push();
+        return;
+    }
+
+    if (!rings_.empty()) {
+        published(1);
+        while (!rings_[lane]->try_push(std::move(task))) {
+            wait_for_ring(1);
+        }
+        notify_push();
+        return;
     }
+
+    {
+        std::scoped_lock lock(lock_);
+        lanes_[lane].push_back(std::move(task));
+        published(1);
+    }
+    notify_push();
 }
 
-void thread_pool::worker() noexcept {
-    auto dequeue = [this] {
-        Task task{};
+void thread_pool::enqueue_deadline(Task &&task, const clock::time_point deadline) noexcept {
+    {
+        std::scoped_lock lock(lock_);
+        deadlines_.push_back(DeadlineTask{deadline, std::move(task)});
+        std::push_heap(deadlines_.begin(), deadlines_.end(), std::greater<>());
+        deadlines_size_++;
+        published(1);
+    }
+    notify_push();
+}
+
+bool thread_pool::dequeue_deadline(Task &task) noexcept {
+    std::scoped_lock lock(lock_);
+    if (deadlines_.empty()) {
+        return false;
+    }
+
+    std::pop_heap(deadlines_.begin(), deadlines_.end(), std::greater<>());
+    task = std::move(deadlines_.back().task);
+    deadlines_.pop_back();
+    deadlines_size_--;
+    queued_--;
+    if (--pending_ == 0) {
+        q_pop_notifier_.notify_one();
+    }
+    if (blocked_ > 0) {
+        q_space_notifier_.notify_one();
+    }
+
+    return true;
+}
+
+void thread_pool::enqueue_bulk(std::vector<Task> &&tasks) noexcept {
+    const auto count = tasks.size();
+    if (count == 0) {
+        return;
+    }
+
+    if (scheduler_ == Scheduler::kWorkStealing && tls_pool == this) {
+        published(count);
+        for (auto &task : tasks) {
+            deques_[tls_index]->push(new Task(std::move(task)));
+        }
+        notify_push(count);
+        return;
+    }
+
+    if (!rings_.empty()) {
+        published(count);
+        for (auto &task : tasks) {
+            while (!rings_[0]->try_push(std::move(task))) {
+                wait_for_ring(count);
+            }
+        }
+        notify_push(count);
+        return;
+    }
 
+    {
         std::scoped_lock lock(lock_);
-        if (!q_.empty()) {
-            task = std::move(q_.front());
-            q_.pop();
-            if (q_.empty()) {
+        for (auto &task : tasks) {
+            lanes_[0].push_back(std::move(task));
+        }
+        published(count);
+    }
+    notify_push(count);
+}
+
+void thread_pool::wait_for_ring(const size_t count) noexcept {
+    // Make sure the workers are draining it
+    notify_push(count);
+    if (tls_pool == this && run_pending_task()) {
+        return;
+    }
+    std::this_thread::yield();
+}
+
+bool thread_pool::dequeue(const size_t index, Task &task) noexcept {
+    const bool worker = (index != kNotWorker);
+
+    // Tasks already batched by this worker
+    if (worker && !tls_batch.empty()) {
+        task = std::move(tls_batch.front());
+        tls_batch.pop_front();
+        on_dequeue();
+        return true;
+    }
+
+    // Deadline tasks go ahead of everything else
+    if (deadlines_size_ > 0 && dequeue_deadline(task)) {
+        return true;
+    }
+
+    // Local deque first, newest task is the most likely to be cache hot
+    if (worker && scheduler_ == Scheduler::kWorkStealing) {
+        if (auto *local = deques_[index]->pop()) {
+            task = std::move(*local);
+            delete local;
+            queued_--;
+            on_dequeue();
+            return true;
+        }
+    }
+
+    if (!rings_.empty()) {
+        if (pop_lane(task).has_value()) {
+            on_dequeue();
+            return true;
+        }
+    } else if (queued_ > 0) {
+        std::scoped_lock lock(lock_);
+        if (const auto lane = pop_lane(task); lane.has_value()) {
+            if (--pending_ == 0) {
                 q_pop_notifier_.notify_one();
             }
+            if (blocked_ > 0) {
+                q_space_notifier_.notify_one();
+            }
+
+            // Grab a batch from the same lane while the lock is held, but never more than this worker's fair share
+            auto &q = lanes_[lane.value()];
+            const auto share = worker ? std::min(batch_size_ - 1, q.size() / std::max<size_t>(live_, 1)) : 0;
+            for (size_t ii = 0; ii < share; ii++) {
+                if (scheduler_ == Scheduler::kWorkStealing) {
+                    // Extra tasks stay visible to thieves
+                    deques_[index]->push(new Task(std::move(q.front())));
+                } else {
+                    tls_batch.push_back(std::move(q.front()));
+                    tls_batch_lane = lane.value();
+                    queued_--;
+                }
+                q.pop_front();
+            }
+
+            return true;
+        }
+    }
+
+    return (scheduler_ == Scheduler::kWorkStealing) && steal(index, task);
+}
+
+bool thread_pool::steal(const size_t index, Task &task) noexcept {
+    // Start with the next worker, threads outside the pool visit every worker
+    const auto size = deques_.size();
+    const auto start = (index == kNotWorker) ? 0 : (index + 1);
+    for (size_t offset = 0; offset < size; offset++) {
+        const auto victim = (start + offset) % size;
+        if (victim == index) {
+            continue;
+        }
+        if (auto *stolen = deques_[victim]->steal()) {
+            task = std::move(*stolen);
+            delete stolen;
+            queued_--;
+            on_dequeue();
+            return true;
         }
+    }
+
+    return false;
+}
+
+void thread_pool::release_batch() noexcept {
+    const auto count = tls_batch.size();
 
-        return task;
+    {
+        std::scoped_lock lock(lock_);
+        while (!tls_batch.empty()) {
+            lanes_[tls_batch_lane].push_front(std::move(tls_batch.back()));
+            tls_batch.pop_back();
+        }
+        queued_ += count;
+    }
+    notify_push(count);
+}
+
+size_t thread_pool::first_lane() noexcept {
+    if (dispatch_ == Dispatch::kStrict || cumulative_weights_.size() == 1) {
+        return 0;
+    }
+
+    const auto ticket = dispatch_ticket_.fetch_add(1, std::memory_order_relaxed) % cumulative_weights_.back();
+    return static_cast<size_t>(std::upper_bound(cumulative_weights_.begin(), cumulative_weights_.end(), ticket) -
+                               cumulative_weights_.begin());
+}
+
+std::optional<size_t> thread_pool::pop_lane(Task &task) noexcept {
+    auto try_lane = [this, &task](const size_t lane) {
+        if (!rings_.empty()) {
+            return rings_[lane]->try_pop(task);
+        }
+
+        auto &q = lanes_[lane];
+        if (q.empty()) {
+            return false;
+        }
+        task = std::move(q.front());
+        q.pop_front();
+        return true;
     };
 
-    auto wait = [this] {
-        std::unique_lock lock(lock_);
+    const auto first = first_lane();
+    for (size_t offset = 0; offset <= cumulative_weights_.size(); offset++) {
+        // The preferred lane, then every lane in priority order
+        const auto lane = (offset == 0) ? first : (offset - 1);
+        if ((offset == 0 || lane != first) && try_lane(lane)) {
+            queued_--;
+            return lane;
+        }
+    }
+
+    return std::nullopt;
+}
+
+void thread_pool::published(const size_t count) noexcept {
+    // Before pending_, so published_total_ - pending_ never underestimates how many tasks have started
+    if (capacity_ > size_) {
+        published_total_ += count;
+    }
+    pending_ += count;
+    queued_ += count;
+}
+
+void thread_pool::on_dequeue() noexcept {
+    const bool drained = (--pending_ == 0);
+    if (drained || blocked_ > 0) {
+        std::scoped_lock lock(lock_);
+        if (drained) {
+            q_pop_notifier_.notify_one();
+        }
+        q_space_notifier_.notify_one();
+    }
+}
+
+void thread_pool::notify_push(const size_t count) noexcept {
+    // Parking workers announce themselves before checking for tasks and tasks are counted before this check,
+    // so either the worker sees the task or this sees the worker
+    if (idle_ == 0) {
+        return;
+    }
+
+    // Most recently parked first, its cache is the warmest
+    size_t woken = 0;
+    while (woken < count) {
+        size_t index = 0;
+        {
+            std::scoped_lock lock(idle_lock_);
+            if (parked_.empty()) {
+                break;
+            }
+            index = parked_.back();
+            parked_.pop_back();
+            idle_--;
+        }
+
+        slots_[index].unpark();
+        woken++;
+    }
+}
+
+bool thread_pool::park(const size_t index) noexcept {
+    // Takes this worker off the list, false if a producer already did and its unpark is on the way
+    auto unlist = [this, index] {
+        std::scoped_lock lock(idle_lock_);
+        const auto it = std::find(parked_.begin(), parked_.end(), index);
+        if (it == parked_.end()) {
+            return false;
+        }
+        parked_.erase(it);
+        idle_--;
+        return true;
+    };
+
+    {
+        std::scoped_lock lock(idle_lock_);
+        parked_.push_back(index);
+        idle_++;
+    }
+
+    // Check again now that producers can see this worker
+    if ((queued_ > 0 || kill_) && unlist()) {
+        return true;
+    }
+
+    if (capacity_ == size_) {
+        slots_[index].park();
+        return true;
+    }
+
+    if (slots_[index].park_for(keep_alive_) || !unlist()) {
+        return true;
+    }
 
-        // Don't wait if there is more to dequeue
-        if (!q_.empty()) {
+    // Idled past the keep alive and no producer can wake this worker anymore
+    return !shrink();
+}
+
+bool thread_pool::shrink() noexcept {
+    const auto now = (clock::now() - timer_epoch_).count();
+    auto last = last_resize_.load();
+    if (live_ <= size_ || now - last < resize_cooldown_.count() || !last_resize_.compare_exchange_strong(last, now)) {
+        return false;
+    }
+
+    auto live = live_.load();
+    while (live > size_) {
+        if (live_.compare_exchange_weak(live, live - 1)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void thread_pool::supervise() noexcept {
+    const auto now = clock::now();
+
+    // Pending first, so the started count is never underestimated
+    const size_t pending = pending_;
+    const size_t published = published_total_;
+    const auto started = published - std::min(pending, published);
+
+    // Everything published before the mark has started, start watching the tasks published since
+    if (started >= wait_mark_) {
+        wait_mark_ = published;
+        wait_mark_time_ = now;
+        return;
+    }
+
+    // A task published before the mark has waited at least now - wait_mark_time_, parked workers mean it is not
+    // waiting for a thread
+    if (now - wait_mark_time_ < grow_threshold_ || idle_ > 0) {
+        return;
+    }
+
+    const auto since_epoch = (now - timer_epoch_).count();
+    auto last = last_resize_.load();
+    if (since_epoch - last < resize_cooldown_.count() || !last_resize_.compare_exchange_strong(last, since_epoch)) {
+        return;
+    }
+
+    size_t index = 0;
+    {
+        std::scoped_lock lock(resize_lock_);
+        if (vacant_.empty()) {
             return;
         }
+        index = vacant_.back();
+        vacant_.pop_back();
+    }
+
+    // The previous worker at this index may still be exiting
+    threads_[index].join();
+    live_++;
+    threads_[index] = thread(thread_params_, &thread_pool::worker, this, index);
+
+    // Give the new worker a full threshold before judging again
+    wait_mark_ = published;
+    wait_mark_time_ = now;
+}
+
+uint64_t thread_pool::current_tick() const noexcept {
+    return static_cast<uint64_t>((clock::now() - timer_epoch_) / timer_resolution_);
+}
+
+timer_handle thread_pool::schedule(const clock::time_point when, const clock::duration period, Task &&task) noexcept {
+    // Round up so tasks never run early
+    const auto since_epoch = std::max(when - timer_epoch_, clock::duration::zero());
+    const auto expiry = static_cast<uint64_t>((since_epoch + timer_resolution_ - clock::duration(1)) / timer_resolution_);
+
+    Timer timer{};
+    if (period > clock::duration::zero()) {
+        timer.period = std::max<uint64_t>((period + timer_resolution_ - clock::duration(1)) / timer_resolution_, 1);
+        timer.periodic = std::make_shared<Periodic>();
+        timer.periodic->task = std::move(task);
+    } else {
+        timer.task = std::move(task);
+    }
+
+    timer_handle handle{};
+    {
+        std::scoped_lock lock(timer_lock_);
+
+        // The timer thread does not advance an empty wheel, catch it up here where that is O(1), otherwise the next
+        // advance would step through every tick it sat idle for with the lock held
+        if (timers_.empty()) {
+            timers_.advance(current_tick(), [](Timer &) -> std::optional<uint64_t> { return std::nullopt; });
+        }
+
+        handle = timers_.insert(expiry, std::move(timer));
+
+        // No timer thread until something is scheduled
+        if (!timer_thread_.joinable() && !kill_) {
+            timer_thread_ = thread(thread_params_, &thread_pool::timer_loop, this);
+        }
+    }
+    timer_notifier_.notify_one();
+
+    return handle;
+}
+
+void thread_pool::timer_loop() noexcept {
+    // An elastic pool is checked a few times per grow threshold
+    const bool elastic = (capacity_ > size_);
+    const auto period = std::max<clock::duration>(grow_threshold_ / 2, std::chrono::microseconds(100));
+    auto next_check = clock::now() + period;
+
+    std::vector<Task> expired;
+
+    std::unique_lock lock(timer_lock_);
+    while (!kill_) {
+        if (elastic && clock::now() >= next_check) {
+            lock.unlock();
+            supervise();
+            lock.lock();
+            next_check = clock::now() + period;
+            continue;
+        }
+
+        if (timers_.empty()) {
+            auto wake = [this] { return kill_ || !timers_.empty(); };
+            if (elastic) {
+                timer_notifier_.wait_until(lock, next_check, wake);
+            } else {
+                timer_notifier_.wait(lock, wake);
+            }
+            continue;
+        }
+
+        // Sleep until the wheel has something to do, an earlier timer being added wakes this up
+        clock::time_point next = timer_epoch_ + timer_resolution_ * timers_.next_tick();
+        if (elastic) {
+            next = std::min(next, next_check);
+        }
+        timer_notifier_.wait_until(lock, next);
+
+        timers_.advance(current_tick(), [this, &expired](Timer &timer) -> std::optional<uint64_t> {
+            if (timer.periodic == nullptr) {
+                expired.push_back(std::move(timer.task));
+                return std::nullopt;
+            }
+
+            // The previous run owns the task until it clears the flag, so only this firing is skipped
+            if (!timer.periodic->in_flight.exchange(true)) {
+                expired.emplace_back([periodic = timer.periodic] {
+                    periodic->task();
+                    periodic->in_flight = false;
+                });
+            }
+            return timers_.now() + timer.period;
+        });
+
+        if (!expired.empty()) {
+            lock.unlock();
+            enqueue_bulk(std::move(expired));
+            expired.clear();
+            lock.lock();
+        }
+    }
+}
+
+void thread_pool::join() noexcept {
+    kill_ = true;
+
+    {
+        std::scoped_lock lock(timer_lock_);
+        timer_notifier_.notify_one();
+    }
+    if (timer_thread_.joinable()) {
+        timer_thread_.join();
+    }
+
+    // Producers blocked on a full queue give up waiting
+    {
+        std::scoped_lock lock(lock_);
+        q_space_notifier_.notify_all();
+    }
+
+    // Parked workers see kill_ when they wake, workers about to park see it in their second check
+    for (size_t t = 0; t < capacity_; t++) {
+        slots_[t].unpark();
+    }
+
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+void thread_pool::worker(const size_t index) noexcept {
+    tls_pool = this;
+    tls_index = index;
+
+    // Busy waits for a task according to the wait policy
+    // \returns true if a task may be available, false if the worker should block
+    auto spin = [this] {
+        if (wait_policy_ == WaitPolicy::kBlock) {
+            return false;
+        }
+
+        // Tasks have recently arrived too far apart for spinning to pay off
+        if (adaptive_threshold_.has_value() && tls_average_idle > adaptive_threshold_.value()) {
+            return false;
+        }
 
-        q_push_notifier_.wait(lock, [this] { return !q_.empty() || kill_; });
+        for (size_t ii = 0; ii < spin_count_; ii++) {
+            if (queued_ > 0 || kill_) {
+                return true;
+            }
+            cpu_relax();
+        }
+
+        if (wait_policy_ == WaitPolicy::kSpinYield) {
+            for (size_t ii = 0; ii < spin_count_; ii++) {
+                if (queued_ > 0 || kill_) {
+                    return true;
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        return false;
     };
 
     while (!kill_) {
-        auto task = dequeue();
-        if (task.valid()) {
+        Task task{};
+        if (!dequeue(index, task)) {
+            if (!adaptive_threshold_.has_value()) {
+                if (!spin() && !park(index)) {
+                    break;
+                }
+                continue;
+            }
+
+            // Track how long this worker typically sits idle
+            const auto start = std::chrono::steady_clock::now();
+            if (!spin() && !park(index)) {
+                break;
+            }
+            const auto idle = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            tls_average_idle += (idle - tls_average_idle) / 8;
+            continue;
+        }
+
+        if (inline_wait_.has_value()) {
+            // Racy between workers, but only an estimate is needed
+            const auto start = clock::now();
             task();
+            const auto ran = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+            const auto average = average_task_ns_.load(std::memory_order_relaxed);
+            average_task_ns_.store(average + (ran - average) / 8, std::memory_order_relaxed);
+        } else {
+            task();
+        }
+
+        // Don't hoard a batch while other workers have nothing to do
+        if (!tls_batch.empty() && idle_ > 0) {
+            release_batch();
         }
+    }
 
-        wait();
+    // Retired, its deque and batch are empty since it found nothing to do, the timer thread joins it before reuse
+    if (!kill_) {
+        std::scoped_lock lock(resize_lock_);
+        vacant_.push_back(index);
     }
 }
 
@@ -0,0 +1,333 @@
+#include "thread_pool/algorithm.h"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace tp;
+
+TEST_CASE("algorithm::ParallelForCoverage", "[algorithm]") {
+    const auto partitioner = GENERATE(Partitioner::kStatic, Partitioner::kDynamic, Partitioner::kGuided,
+                                      Partitioner::kAuto);
+    const size_t size = GENERATE(1, 4);
+    const size_t n = GENERATE(0, 1, 7, 1000, 100003);
+    const size_t grain = GENERATE(0, 3);
+    thread_pool tp({.size = size});
+
+    // Every index exactly once
+    std::vector<std::atomic<uint8_t>> visits(n);
+    parallel_for(tp, size_t{0}, n, [&visits](const size_t ii) { visits[ii]++; },
+                 {.partitioner = partitioner, .grain = grain});
+
+    size_t wrong = 0;
+    for (auto &count : visits) {
+        wrong += (count != 1);
+    }
+    REQUIRE(wrong == 0);
+}
+
+TEST_CASE("algorithm::ParallelForSignedRange", "[algorithm]") {
+    thread_pool tp({.size = 2});
+    std::atomic<int64_t> sum = 0;
+    parallel_for(tp, -500, 500, [&sum](const int ii) { sum += ii; });
+    REQUIRE(sum == -500);
+
+    // Empty and reversed ranges do nothing
+    parallel_for(tp, 10, 10, [&sum](const int) { sum = 0; });
+    parallel_for(tp, 10, 0, [&sum](const int) { sum = 0; });
+    REQUIRE(sum == -500);
+}
+
+TEST_CASE("algorithm::ParallelForExtremeRange", "[algorithm]") {
+    // Ranges wider than the index type's max
+    thread_pool tp({.size = 2});
+    std::atomic<int64_t> sum = 0;
+    std::atomic<size_t> count = 0;
+    parallel_for(tp, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max(),
+                 [&sum, &count](const int16_t ii) {
+                     sum += ii;
+                     count++;
+                 });
+    REQUIRE(count == 65535);
+    REQUIRE(sum == -65535);
+
+    const auto reduced = parallel_reduce(tp, std::numeric_limits<int8_t>::min(), std::numeric_limits<int8_t>::max(),
+                                         int64_t{0}, [](const int8_t ii) { return int64_t{ii}; }, std::plus<>());
+    REQUIRE(reduced == -255);
+}
+
+TEST_CASE("algorithm::ParallelForNested", "[algorithm]") {
+    const auto scheduler = GENERATE(thread_pool::Scheduler::kGlobalQueue, thread_pool::Scheduler::kWorkStealing);
+    thread_pool tp({.size = 2, .scheduler = scheduler});
+
+    std::atomic<size_t> count = 0;
+    auto future = tp.push([&tp, &count] {
+        parallel_for(tp, 0, 100, [&tp, &count](int) {
+            parallel_for(tp, 0, 100, [&count](int) { count++; });
+        });
+    });
+    future.get();
+    REQUIRE(count == 10000);
+}
+
+TEST_CASE("algorithm::ParallelForException", "[algorithm]") {
+    const auto partitioner = GENERATE(Partitioner::kStatic, Partitioner::kDynamic, Partitioner::kGuided,
+                                      Partitioner::kAuto);
+    thread_pool tp({.size = 2});
+
+    auto loop = [&tp, partitioner] {
+        parallel_for(tp, 0, 1000, [](const int ii) {
+            if (ii == 500) {
+                throw std::runtime_error("500");
+            }
+        }, {.partitioner = partitioner});
+    };
+    REQUIRE_THROWS_AS(loop(), std::runtime_error);
+}
+
+TEST_CASE("algorithm::ParallelForBenchmark", "[.][benchmark]") {
+    constexpr size_t kElements = 10'000'000;
+    std::vector<double> values(kElements, 1.0);
+
+    for (const size_t size : {1, 2, 4, 8}) {
+        thread_pool tp({.size = size});
+        for (const auto partitioner :
+             {Partitioner::kStatic, Partitioner::kDynamic, Partitioner::kGuided, Partitioner::kAuto}) {
+            const auto start = std::chrono::steady_clock::now();
+            parallel_for(tp, size_t{0}, kElements, [&values](const size_t ii) { values[ii] = values[ii] * 1.5 + 1.0; },
+                         {.partitioner = partitioner});
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+
+            std::cout << "parallel_for " << kElements << " elements, " << size << " workers, partitioner "
+                      << static_cast<int>(partitioner) << ": "
+                      << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() << "us" << std::endl;
+        }
+    }
+}
+
+TEST_CASE("algorithm::ParallelReduce", "[algorithm]") {
+    const auto partitioner = GENERATE(Partitioner::kStatic, Partitioner::kDynamic, Partitioner::kGuided,
+                                      Partitioner::kAuto);
+    const size_t size = GENERATE(1, 4);
+    thread_pool tp({.size = size});
+    const ParallelParams params{.partitioner = partitioner};
+
+    SECTION("Sum") {
+        constexpr uint64_t kElements = 100003;
+        const auto sum = parallel_reduce(tp, uint64_t{0}, kElements, uint64_t{0}, [](const uint64_t ii) { return ii; },
+                                         std::plus<>(), params);
+        REQUIRE(sum == kElements * (kElements - 1) / 2);
+    }
+
+    SECTION("Max") {
+        std::vector<int> values(5000);
+        std::iota(values.begin(), values.end(), -2500);
+        std::swap(values[1234], values.back());
+        const auto max = parallel_reduce(tp, size_t{0}, values.size(), INT32_MIN,
+                                         [&values](const size_t ii) { return values[ii]; },
+                                         [](const int a, const int b) { return std::max(a, b); }, params);
+        REQUIRE(max == 2499);
+    }
+
+    SECTION("Empty") {
+        REQUIRE(parallel_reduce(tp, 5, 5, 42, [](int) { return 1; }, std::plus<>(), params) == 42);
+    }
+
+    SECTION("TransformReduce") {
+        const std::vector<int> values{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        const auto squares = parallel_transform_reduce(tp, values.begin(), values.end(), int64_t{0}, std::plus<>(),
+                                                       [](const int value) { return int64_t{value} * value; }, params);
+        REQUIRE(squares == 385);
+    }
+}
+
+TEST_CASE("algorithm::ParallelReduceBenchmark", "[.][benchmark]") {
+    constexpr size_t kElements = 50'000'000;
+
+    for (const size_t size : {1, 2, 4, 8, 16, 32, 64}) {
+        thread_pool tp({.size = size});
+
+        // Every element bounces the counter's cache line between cores
+        std::atomic<uint64_t> counter = 0;
+        auto start = std::chrono::steady_clock::now();
+        parallel_for(tp, size_t{0}, kElements, [&counter](const size_t ii) {
+            counter.fetch_add(ii & 1, std::memory_order_relaxed);
+        });
+        const auto atomic_elapsed = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        const auto sum = parallel_reduce(tp, size_t{0}, kElements, uint64_t{0}, [](const size_t ii) { return ii & 1; },
+                                         std::plus<>());
+        const auto reduce_elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(sum == counter);
+
+        std::cout << "reduce " << kElements << " elements, " << size << " workers: atomic "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(atomic_elapsed).count() << "us, partials "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(reduce_elapsed).count() << "us"
+                  << std::endl;
+    }
+}
+
+TEST_CASE("algorithm::ParallelSort", "[algorithm]") {
+    const size_t size = GENERATE(1, 4);
+    const size_t n = GENERATE(0, 1, 100, 4097, 100003);
+    thread_pool tp({.size = size});
+
+    std::mt19937 generator(n);
+    std::vector<int> values(n);
+    for (auto &value : values) {
+        value = static_cast<int>(generator() % 1000);
+    }
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    SECTION("Ascending") {
+        parallel_sort(tp, values.begin(), values.end());
+        REQUIRE(values == expected);
+    }
+
+    SECTION("Descending") {
+        parallel_sort(tp, values.begin(), values.end(), std::greater<>());
+        std::reverse(expected.begin(), expected.end());
+        REQUIRE(values == expected);
+    }
+}
+
+TEST_CASE("algorithm::ParallelSortMoveOnly", "[algorithm]") {
+    thread_pool tp({.size = 3});
+    std::vector<std::unique_ptr<int>> values;
+    for (int ii = 50000; ii > 0; ii--) {
+        values.push_back(std::make_unique<int>(ii));
+    }
+
+    parallel_sort(tp, values.begin(), values.end(), [](const auto &a, const auto &b) { return *a < *b; });
+    REQUIRE(std::is_sorted(values.begin(), values.end(), [](const auto &a, const auto &b) { return *a < *b; }));
+    REQUIRE(*values.front() == 1);
+}
+
+TEST_CASE("algorithm::ParallelInclusiveScan", "[algorithm]") {
+    const size_t size = GENERATE(1, 4);
+    const size_t n = GENERATE(0, 1, 100, 4096 * 3, 100003);
+    thread_pool tp({.size = size});
+
+    std::vector<uint64_t> values(n);
+    std::iota(values.begin(), values.end(), 1);
+    std::vector<uint64_t> expected(n);
+    std::inclusive_scan(values.begin(), values.end(), expected.begin());
+
+    SECTION("OutOfPlace") {
+        std::vector<uint64_t> output(n);
+        REQUIRE(parallel_inclusive_scan(tp, values.begin(), values.end(), output.begin()) == output.end());
+        REQUIRE(output == expected);
+    }
+
+    SECTION("InPlace") {
+        parallel_inclusive_scan(tp, values.begin(), values.end(), values.begin());
+        REQUIRE(values == expected);
+    }
+
+    SECTION("NonCommutative") {
+        // Composing affine maps x -> a * x + b checks that chunks are combined in order
+        using Affine = std::pair<uint64_t, uint64_t>;
+        auto compose = [](const Affine &first, const Affine &second) {
+            return Affine{first.first * second.first, first.second * second.first + second.second};
+        };
+
+        std::vector<Affine> maps(n);
+        for (size_t ii = 0; ii < n; ii++) {
+            maps[ii] = Affine{ii % 7 + 1, ii};
+        }
+        std::vector<Affine> output(n);
+        parallel_inclusive_scan(tp, maps.begin(), maps.end(), output.begin(), compose);
+
+        std::vector<Affine> serial(n);
+        std::inclusive_scan(maps.begin(), maps.end(), serial.begin(), compose);
+        REQUIRE(output == serial);
+    }
+}
+
+TEST_CASE("algorithm::ParallelSortScanBenchmark", "[.][benchmark]") {
+    const auto size = std::max<size_t>(thread::hardware_concurrency(), 2);
+    thread_pool tp({.size = size});
+
+    auto time = [](auto &&run) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    for (const size_t n : {10'000, 100'000, 1'000'000, 10'000'000}) {
+        std::mt19937_64 generator(n);
+        std::vector<uint64_t> values(n);
+        for (auto &value : values) {
+            value = generator();
+        }
+
+        auto serial = values;
+        const auto sort_us = time([&serial] { std::sort(serial.begin(), serial.end()); });
+        auto parallel = values;
+        const auto parallel_sort_us = time([&tp, &parallel] { parallel_sort(tp, parallel.begin(), parallel.end()); });
+        REQUIRE(serial == parallel);
+
+        const auto scan_us = time([&serial, &values] {
+            std::inclusive_scan(values.begin(), values.end(), serial.begin());
+        });
+        const auto parallel_scan_us = time([&tp, &parallel, &values] {
+            parallel_inclusive_scan(tp, values.begin(), values.end(), parallel.begin());
+        });
+        REQUIRE(serial == parallel);
+
+        std::cout << n << " elements, " << size << " workers: std::sort " << sort_us << "us, parallel_sort "
+                  << parallel_sort_us << "us, std::inclusive_scan " << scan_us << "us, parallel_inclusive_scan "
+                  << parallel_scan_us << "us" << std::endl;
+    }
+}
+
+TEST_CASE("algorithm::ParallelReduceElastic", "[algorithm]") {
+    const auto partitioner = GENERATE(Partitioner::kStatic, Partitioner::kDynamic, Partitioner::kAuto);
+    constexpr size_t kMaxSize = 8;
+    thread_pool tp({.size = 1,
+                    .max_size = kMaxSize,
+                    .grow_threshold = std::chrono::milliseconds(1),
+                    .keep_alive = std::chrono::milliseconds(30),
+                    .resize_cooldown = std::chrono::milliseconds(1)});
+
+    // Grow by keeping every worker blocked, then let most of them retire, so live workers have high indices
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::vector<std::future<void>> blockers;
+    for (size_t ii = 0; ii < kMaxSize * 2; ii++) {
+        blockers.push_back(tp.push([opened] { opened.wait(); }));
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (tp.size() < kMaxSize && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(tp.size() == kMaxSize);
+    gate.set_value();
+    for (auto &blocker : blockers) {
+        blocker.get();
+    }
+    while (tp.size() > 2 && std::chrono::steady_clock::now() < deadline + std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    constexpr uint64_t kElements = 100003;
+    const auto sum = parallel_reduce(tp, uint64_t{0}, kElements, uint64_t{0}, [](const uint64_t ii) { return ii; },
+                                     std::plus<>(), ParallelParams{.partitioner = partitioner});
+    REQUIRE(sum == kElements * (kElements - 1) / 2);
+}
@@ -0,0 +1,197 @@
+#include "thread_pool/future.h"
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tp;
+
+TEST_CASE("future::Async", "[future]") {
+    thread_pool tp({.size = 2});
+
+    auto value = async(tp, [](const int a, const int b) { return a + b; }, 1, 2);
+    REQUIRE(value.valid());
+    REQUIRE(value.get() == 3);
+    REQUIRE(!value.valid());
+
+    std::atomic<bool> ran = false;
+    async(tp, [&ran] { ran = true; }).get();
+    REQUIRE(ran);
+
+    auto failed = async(tp, []() -> int { throw std::runtime_error("failed"); });
+    REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+}
+
+TEST_CASE("future::Then", "[future]") {
+    thread_pool tp({.size = 2});
+
+    SECTION("Chain") {
+        auto result = async(tp, [] { return 2; })
+                          .then([](const int value) { return value * 10; })
+                          .then([](const int value) { return std::to_string(value); })
+                          .then([](const std::string &value) { return value + "!"; });
+        REQUIRE(result.get() == "20!");
+    }
+
+    SECTION("Void") {
+        std::atomic<int> order = 0;
+        auto result = async(tp, [&order] { order = 1; }).then([&order] { return order.load() + 1; });
+        REQUIRE(result.get() == 2);
+    }
+
+    SECTION("MoveOnly") {
+        auto result = async(tp, [] { return std::make_unique<int>(5); })
+                          .then([](std::unique_ptr<int> value) { return *value; });
+        REQUIRE(result.get() == 5);
+    }
+
+    SECTION("ExceptionSkipsContinuation") {
+        std::atomic<bool> ran = false;
+        auto result = async(tp, []() -> int { throw std::runtime_error("failed"); })
+                          .then([&ran](const int value) {
+                              ran = true;
+                              return value;
+                          });
+        REQUIRE_THROWS_AS(result.get(), std::runtime_error);
+        REQUIRE(!ran);
+    }
+
+    SECTION("AlreadyReady") {
+        auto first = async(tp, [] { return 1; });
+        first.wait();
+        REQUIRE(first.is_ready());
+        REQUIRE(first.then([](const int value) { return value + 1; }).get() == 2);
+    }
+}
+
+TEST_CASE("future::Promise", "[future]") {
+    thread_pool tp({.size = 1});
+
+    SECTION("FromOutside") {
+        promise<int> source(tp);
+        auto result = source.get_future().then([](const int value) { return value * 2; });
+        REQUIRE_THROWS_AS(source.get_future(), std::future_error);
+
+        std::thread producer([&source] { source.set_value(21); });
+        REQUIRE(result.get() == 42);
+        producer.join();
+    }
+
+    SECTION("Broken") {
+        future<void> result;
+        {
+            promise<void> source(tp);
+            result = source.get_future();
+        }
+        REQUIRE_THROWS_AS(result.get(), std::future_error);
+    }
+}
+
+TEST_CASE("future::WhenAll", "[future]") {
+    thread_pool tp({.size = 4});
+
+    SECTION("Values") {
+        std::vector<future<int>> futures;
+        for (int ii = 0; ii < 100; ii++) {
+            futures.push_back(async(tp, [ii] { return ii * ii; }));
+        }
+
+        auto all = when_all(std::move(futures)).then([](const std::vector<int> &values) {
+            int sum = 0;
+            for (size_t ii = 0; ii < values.size(); ii++) {
+                sum += (values[ii] == static_cast<int>(ii * ii)) ? 1 : 0;
+            }
+            return sum;
+        });
+        REQUIRE(all.get() == 100);
+    }
+
+    SECTION("Void") {
+        std::atomic<int> count = 0;
+        std::vector<future<void>> futures;
+        for (int ii = 0; ii < 10; ii++) {
+            futures.push_back(async(tp, [&count] { count++; }));
+        }
+        when_all(std::move(futures)).get();
+        REQUIRE(count == 10);
+    }
+
+    SECTION("Exception") {
+        std::vector<future<int>> futures;
+        futures.push_back(async(tp, [] { return 1; }));
+        futures.push_back(async(tp, []() -> int { throw std::runtime_error("failed"); }));
+        REQUIRE_THROWS_AS(when_all(std::move(futures)).get(), std::runtime_error);
+    }
+
+    SECTION("Empty") {
+        auto values = when_all(std::vector<future<int>>{});
+        REQUIRE(values.is_ready());
+        REQUIRE(values.then([](const std::vector<int> &values) { return values.size(); }).get() == 0);
+
+        auto done = when_all(std::vector<future<void>>{});
+        REQUIRE(done.is_ready());
+        REQUIRE_NOTHROW(done.get());
+    }
+}
+
+TEST_CASE("future::WhenAny", "[future]") {
+    thread_pool tp({.size = 2});
+
+    promise<int> never(tp);
+    std::vector<future<int>> futures;
+    futures.push_back(never.get_future());
+    futures.push_back(async(tp, [] { return 7; }));
+
+    const auto first = when_any(std::move(futures)).get();
+    REQUIRE(first.index == 1);
+    REQUIRE(first.value == 7);
+    never.set_value(0);
+
+    // Nothing can complete an empty when_any
+    auto empty = when_any(std::vector<future<int>>{});
+    REQUIRE(empty.is_ready());
+    REQUIRE_THROWS_AS(empty.get(), std::future_error);
+}
+
+TEST_CASE("future::DroppedOnShutdown", "[future]") {
+    auto tp = std::make_unique<thread_pool>(thread_pool::Params{.size = 1});
+
+    // Hold the only worker until the pool is shutting down, so the task below is never run
+    std::promise<void> gate;
+    std::promise<void> started;
+    tp->push([&started, opened = gate.get_future()]() mutable {
+        started.set_value();
+        opened.wait();
+    });
+    started.get_future().wait();
+
+    auto dropped = async(*tp, [] { return 1; });
+    auto chained = async(*tp, [] { return 2; }).then([](const int value) { return value * 2; });
+
+    std::thread opener([&gate] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        gate.set_value();
+    });
+    tp->join(false);
+    opener.join();
+    tp.reset();
+
+    REQUIRE(dropped.is_ready());
+    REQUIRE_THROWS_AS(dropped.get(), std::future_error);
+    REQUIRE(chained.is_ready());
+    REQUIRE_THROWS_AS(chained.get(), std::future_error);
+}
+
+TEST_CASE("future::NestedWaitOnSingleWorker", "[future]") {
+    // get() from the only worker runs the inner task instead of deadlocking
+    thread_pool tp({.size = 1});
+    auto outer = async(tp, [&tp] { return async(tp, [] { return 3; }).get() + 1; });
+    REQUIRE(outer.get() == 4);
+}
@@ -0,0 +1,168 @@
+#include "thread_pool/mpmc_queue.h"
+#include "thread_pool/thread.h"
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace tp;
+
+TEST_CASE("mpmc_queue::Capacity", "[mpmc_queue]") {
+    mpmc_queue<int> q(5);
+    REQUIRE(q.capacity() == 8);
+    REQUIRE(q.empty());
+
+    for (int ii = 0; ii < 8; ii++) {
+        REQUIRE(q.try_push(std::move(ii)));
+    }
+    REQUIRE(q.size() == 8);
+
+    int overflow = 8;
+    REQUIRE(!q.try_push(std::move(overflow)));
+
+    int value = -1;
+    for (int ii = 0; ii < 8; ii++) {
+        REQUIRE(q.try_pop(value));
+        REQUIRE(value == ii);
+    }
+    REQUIRE(!q.try_pop(value));
+}
+
+TEST_CASE("mpmc_queue::MoveOnly", "[mpmc_queue]") {
+    mpmc_queue<std::unique_ptr<int>> q(4);
+    REQUIRE(q.try_push(std::make_unique<int>(1)));
+
+    std::unique_ptr<int> value;
+    REQUIRE(q.try_pop(value));
+    REQUIRE(*value == 1);
+
+    // Leftover elements are destroyed with the queue
+    REQUIRE(q.try_push(std::make_unique<int>(2)));
+}
+
+TEST_CASE("mpmc_queue::Concurrent", "[mpmc_queue]") {
+    constexpr size_t kNumThreads = 4;
+    constexpr size_t kNumElements = 100000;
+
+    mpmc_queue<size_t> q(64);
+    std::atomic<size_t> sum = 0;
+    std::atomic<size_t> popped = 0;
+
+    std::vector<thread> threads;
+    for (size_t t = 0; t < kNumThreads; t++) {
+        threads.push_back(thread([&q] {
+            for (size_t ii = 1; ii <= kNumElements; ii++) {
+                auto value = ii;
+                while (!q.try_push(std::move(value))) {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+        threads.push_back(thread([&q, &sum, &popped] {
+            size_t value = 0;
+            while (popped < kNumThreads * kNumElements) {
+                if (q.try_pop(value)) {
+                    sum += value;
+                    popped++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    REQUIRE(sum == kNumThreads * (kNumElements * (kNumElements + 1) / 2));
+}
+
+namespace {
+
+/// The pool's original queue, for comparison
+template <typename T>
+class mutex_queue {
+  public:
+    bool try_push(T &&element) {
+        std::scoped_lock lock(lock_);
+        q_.push(std::move(element));
+        return true;
+    }
+
+    bool try_pop(T &element) {
+        std::scoped_lock lock(lock_);
+        if (q_.empty()) {
+            return false;
+        }
+        element = std::move(q_.front());
+        q_.pop();
+        return true;
+    }
+
+  private:
+    std::mutex lock_;
+    std::queue<T> q_;
+};
+
+/// Pushes and pops kNumElements through the queue, returns millions of elements per second
+template <typename Queue>
+double throughput(Queue &q, const size_t producers, const size_t consumers) {
+    constexpr size_t kNumElements = 1 << 20;
+    const size_t per_producer = kNumElements / producers;
+    const size_t total = per_producer * producers;
+    std::atomic<size_t> popped = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<thread> threads;
+    for (size_t t = 0; t < producers; t++) {
+        threads.push_back(thread([&q, per_producer] {
+            for (size_t ii = 0; ii < per_producer; ii++) {
+                auto value = ii;
+                while (!q.try_push(std::move(value))) {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (size_t t = 0; t < consumers; t++) {
+        threads.push_back(thread([&q, &popped, total] {
+            size_t value = 0;
+            while (popped < total) {
+                if (q.try_pop(value)) {
+                    popped++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(total) / elapsed.count() / 1e6;
+}
+
+} // namespace
+
+TEST_CASE("mpmc_queue::Benchmark", "[.][benchmark]") {
+    constexpr size_t kConsumers = 4;
+
+    std::cout << "producers, mutex queue (M/s), mpmc queue (M/s)" << std::endl;
+    for (size_t producers = 1; producers <= 64; producers *= 2) {
+        mutex_queue<size_t> locked;
+        mpmc_queue<size_t> lock_free(1024);
+        const auto locked_rate = throughput(locked, producers, kConsumers);
+        const auto lock_free_rate = throughput(lock_free, producers, kConsumers);
+        std::cout << producers << ", " << locked_rate << ", " << lock_free_rate << std::endl;
+    }
+}
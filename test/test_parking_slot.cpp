@@ -0,0 +1,56 @@
+#include "thread_pool/parking_slot.h"
+#include "thread_pool/thread.h"
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace tp;
+
+TEST_CASE("parking_slot::UnparkBeforePark", "[parking_slot]") {
+    parking_slot slot;
+    slot.unpark();
+
+    // Wakeup is remembered
+    slot.park();
+}
+
+TEST_CASE("parking_slot::ParkFor", "[parking_slot]") {
+    parking_slot slot;
+
+    SECTION("Timeout") {
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(!slot.park_for(std::chrono::milliseconds(10)));
+        REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(10));
+    }
+
+    SECTION("Unparked") {
+        slot.unpark();
+        REQUIRE(slot.park_for(std::chrono::seconds(10)));
+    }
+}
+
+TEST_CASE("parking_slot::CrossThread", "[parking_slot]") {
+    constexpr size_t kRounds = 1000;
+    parking_slot ping;
+    parking_slot pong;
+    std::atomic<size_t> count = 0;
+
+    thread t([&] {
+        for (size_t ii = 0; ii < kRounds; ii++) {
+            ping.park();
+            count++;
+            pong.unpark();
+        }
+    });
+
+    for (size_t ii = 0; ii < kRounds; ii++) {
+        ping.unpark();
+        pong.park();
+    }
+
+    t.join();
+    REQUIRE(count == kRounds);
+}
@@ -0,0 +1,176 @@
+#include "thread_pool/pipeline.h"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+using namespace tp;
+
+namespace {
+
+/// Source producing 0 to count - 1
+auto counter(const size_t count) {
+    return [next = size_t{0}, count]() mutable -> std::optional<size_t> {
+        if (next == count) {
+            return std::nullopt;
+        }
+        return next++;
+    };
+}
+
+/// Tracks the most threads inside a region at once
+struct Concurrency {
+    void enter() {
+        const auto now = ++inside;
+        auto seen = most.load();
+        while (now > seen && !most.compare_exchange_weak(seen, now)) {
+        }
+    }
+
+    void exit() {
+        inside--;
+    }
+
+    std::atomic<size_t> inside{0};
+    std::atomic<size_t> most{0};
+};
+
+} // namespace
+
+TEST_CASE("pipeline::InOrder", "[pipeline]") {
+    const auto scheduler = GENERATE(thread_pool::Scheduler::kGlobalQueue, thread_pool::Scheduler::kWorkStealing);
+    thread_pool tp({.size = 4, .scheduler = scheduler});
+
+    // The parallel stage finishes items out of order, the in order sink still sees them in source order
+    constexpr size_t kItems = 2000;
+    std::vector<size_t> output;
+    auto line = pipeline::from(counter(kItems))
+                    .then(pipeline::Mode::kParallel, [](const size_t value) { return value * 2; })
+                    .to(pipeline::Mode::kSerialInOrder, [&output](const size_t value) { output.push_back(value); });
+
+    // An exhausted source stays exhausted, running again does nothing
+    line.run(tp, 8);
+    REQUIRE(output.size() == kItems);
+    for (size_t ii = 0; ii < kItems; ii++) {
+        REQUIRE(output[ii] == ii * 2);
+    }
+    line.run(tp, 8);
+    REQUIRE(output.size() == kItems);
+}
+
+TEST_CASE("pipeline::Tokens", "[pipeline]") {
+    thread_pool tp({.size = 4});
+    constexpr size_t kTokens = 3;
+
+    // Items are counted from leaving the source to leaving the sink
+    std::atomic<size_t> in_flight = 0;
+    std::atomic<size_t> most = 0;
+    size_t produced = 0;
+    auto line = pipeline::from([&]() -> std::optional<size_t> {
+                    if (produced == 500) {
+                        return std::nullopt;
+                    }
+                    const auto now = ++in_flight;
+                    most = std::max(most.load(), now);
+                    return produced++;
+                })
+                    .then(pipeline::Mode::kParallel, [](const size_t value) { return value + 1; })
+                    .to(pipeline::Mode::kSerialOutOfOrder, [&in_flight](const size_t) { in_flight--; });
+
+    line.run(tp, kTokens);
+    REQUIRE(produced == 500);
+    REQUIRE(in_flight == 0);
+    REQUIRE(most <= kTokens);
+}
+
+TEST_CASE("pipeline::SerialStages", "[pipeline]") {
+    thread_pool tp({.size = 4});
+
+    // Serial stages never overlap with themselves even when items queue up behind them
+    Concurrency out_of_order;
+    Concurrency in_order;
+    std::atomic<size_t> sum = 0;
+    auto line = pipeline::from(counter(1000))
+                    .then(pipeline::Mode::kSerialOutOfOrder,
+                          [&out_of_order](const size_t value) {
+                              out_of_order.enter();
+                              out_of_order.exit();
+                              return value;
+                          })
+                    .then(pipeline::Mode::kParallel, [](const size_t value) { return value; })
+                    .to(pipeline::Mode::kSerialInOrder, [&in_order, &sum](const size_t value) {
+                        in_order.enter();
+                        sum += value;
+                        in_order.exit();
+                    });
+
+    line.run(tp, 16);
+    REQUIRE(out_of_order.most == 1);
+    REQUIRE(in_order.most == 1);
+    REQUIRE(sum == 999 * 1000 / 2);
+}
+
+TEST_CASE("pipeline::MoveOnly", "[pipeline]") {
+    thread_pool tp({.size = 2});
+    size_t sum = 0;
+
+    auto line = pipeline::from(counter(100))
+                    .then(pipeline::Mode::kParallel, [](const size_t value) { return std::make_unique<size_t>(value); })
+                    .to(pipeline::Mode::kSerialInOrder, [&sum](std::unique_ptr<size_t> value) { sum += *value; });
+
+    line.run(tp, 4);
+    REQUIRE(sum == 99 * 100 / 2);
+}
+
+TEST_CASE("pipeline::Exception", "[pipeline]") {
+    thread_pool tp({.size = 2});
+    std::atomic<size_t> consumed = 0;
+
+    SECTION("Stage") {
+        auto line = pipeline::from(counter(1000))
+                        .then(pipeline::Mode::kParallel,
+                              [](const size_t value) {
+                                  if (value == 10) {
+                                      throw std::runtime_error("stage");
+                                  }
+                                  return value;
+                              })
+                        .to(pipeline::Mode::kSerialInOrder, [&consumed](const size_t) { consumed++; });
+
+        // The source stops soon after the failure
+        REQUIRE_THROWS_AS(line.run(tp, 4), std::runtime_error);
+        REQUIRE(consumed < 1000);
+    }
+
+    SECTION("Source") {
+        size_t produced = 0;
+        auto line = pipeline::from([&produced]() -> std::optional<size_t> {
+                        if (produced == 10) {
+                            throw std::runtime_error("source");
+                        }
+                        return produced++;
+                    }).to(pipeline::Mode::kParallel, [&consumed](const size_t) { consumed++; });
+
+        REQUIRE_THROWS_AS(line.run(tp, 4), std::runtime_error);
+        REQUIRE(produced == 10);
+    }
+}
+
+TEST_CASE("pipeline::RunFromWorker", "[pipeline]") {
+    // The only worker runs every stage itself while it waits
+    thread_pool tp({.size = 1});
+    std::vector<size_t> output;
+
+    auto line = pipeline::from(counter(100))
+                    .then(pipeline::Mode::kParallel, [](const size_t value) { return value + 1; })
+                    .to(pipeline::Mode::kSerialInOrder, [&output](const size_t value) { output.push_back(value); });
+
+    tp.push([&line, &tp] { line.run(tp, 4); }).get();
+    REQUIRE(output.size() == 100);
+    REQUIRE(output.back() == 100);
+}
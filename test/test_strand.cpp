@@ -0,0 +1,114 @@
+#include "thread_pool/strand.h"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace tp;
+
+TEST_CASE("strand::Order", "[strand]") {
+    const auto scheduler = GENERATE(thread_pool::Scheduler::kGlobalQueue, thread_pool::Scheduler::kWorkStealing);
+    thread_pool tp({.size = 4, .scheduler = scheduler});
+    strand serial(tp);
+
+    // Unsynchronized on purpose, the strand must never run two tasks at once
+    std::vector<size_t> order;
+    std::atomic<size_t> running = 0;
+    std::atomic<size_t> overlaps = 0;
+    constexpr size_t kTasks = 10000;
+    for (size_t ii = 0; ii < kTasks; ii++) {
+        serial.post([&order, &running, &overlaps, ii] {
+            overlaps += (running++ != 0);
+            order.push_back(ii);
+            running--;
+        });
+    }
+
+    auto last = serial.push([&order] { return order.size(); });
+    REQUIRE(last.get() == kTasks);
+    REQUIRE(overlaps == 0);
+    for (size_t ii = 0; ii < kTasks; ii++) {
+        REQUIRE(order[ii] == ii);
+    }
+}
+
+TEST_CASE("strand::Exception", "[strand]") {
+    thread_pool tp({.size = 2});
+    strand serial(tp);
+
+    auto failed = serial.push([]() -> int { throw std::runtime_error("failed"); });
+    auto next = serial.push([] { return 1; });
+    REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+    REQUIRE(next.get() == 1);
+}
+
+TEST_CASE("serial_executor::PerKeyOrder", "[serial_executor]") {
+    thread_pool tp({.size = 4});
+    serial_executor<std::string> executor(tp, 8);
+
+    constexpr size_t kKeys = 50;
+    constexpr size_t kTasksPerKey = 200;
+    std::vector<std::vector<size_t>> orders(kKeys);
+    std::vector<std::future<void>> futures;
+
+    // Interleave keys so their strands run side by side
+    for (size_t task = 0; task < kTasksPerKey; task++) {
+        for (size_t key = 0; key < kKeys; key++) {
+            futures.push_back(executor.push("session" + std::to_string(key), [&orders, key, task] {
+                orders[key].push_back(task);
+            }));
+        }
+    }
+    for (auto &future : futures) {
+        future.get();
+    }
+
+    for (const auto &order : orders) {
+        REQUIRE(order.size() == kTasksPerKey);
+        for (size_t task = 0; task < kTasksPerKey; task++) {
+            REQUIRE(order[task] == task);
+        }
+    }
+}
+
+TEST_CASE("serial_executor::IdleKeysDropped", "[serial_executor]") {
+    thread_pool tp({.size = 2});
+    serial_executor<uint64_t> executor(tp);
+
+    constexpr uint64_t kKeys = 100000;
+    std::atomic<uint64_t> ran = 0;
+    for (uint64_t key = 0; key < kKeys; key++) {
+        executor.post(key, [&ran] { ran++; });
+    }
+    tp.join(true);
+    REQUIRE(ran == kKeys);
+    REQUIRE(executor.active() == 0);
+}
+
+TEST_CASE("serial_executor::Benchmark", "[.][benchmark]") {
+    constexpr uint64_t kTasks = 1'000'000;
+
+    for (const uint64_t keys : {1, 100, 100'000}) {
+        thread_pool tp({.size = std::max<size_t>(thread::hardware_concurrency(), 2)});
+        serial_executor<uint64_t> executor(tp);
+        std::atomic<uint64_t> ran = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t ii = 0; ii < kTasks; ii++) {
+            executor.post(ii % keys, [&ran] { ran.fetch_add(1, std::memory_order_relaxed); });
+        }
+        tp.join(true);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "serial_executor " << kTasks << " tasks over " << keys << " keys: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << "ms" << std::endl;
+    }
+}
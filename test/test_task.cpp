@@ -0,0 +1,86 @@
+#include "thread_pool/task.h"
+#include "test_utils.h"
+
+#include "catch.hpp"
+
+#include <array>
+#include <future>
+#include <memory>
+
+using namespace tp;
+
+TEST_CASE("task::DefaultConstructible", "[task]") {
+    task t;
+    REQUIRE(!t.valid());
+    REQUIRE(!t);
+}
+
+TEST_CASE("task::Work", "[task]") {
+    SECTION("Lambda") {
+        size_t count = 0;
+        task t([&count] { lambda(count); });
+        REQUIRE(t.valid());
+        t();
+        REQUIRE(count == 1);
+    }
+
+    SECTION("Functor") {
+        Functor::count = 0;
+        task t(Functor{});
+        t();
+        REQUIRE(Functor::count == 1);
+    }
+
+    SECTION("PackagedTask") {
+        std::packaged_task<void()> packaged([] {});
+        auto future = packaged.get_future();
+        task t(std::move(packaged));
+        t();
+        REQUIRE(std::future_status::ready == future.wait_for(std::chrono::seconds(0)));
+    }
+}
+
+TEST_CASE("task::MoveOnlyCapture", "[task]") {
+    auto value = std::make_unique<size_t>(0);
+    auto *raw = value.get();
+    task t([value = std::move(value)] { (*value)++; });
+
+    task moved(std::move(t));
+    REQUIRE(!t.valid());
+    REQUIRE(moved.valid());
+
+    moved();
+    REQUIRE(*raw == 1);
+}
+
+TEST_CASE("task::LargeCapture", "[task]") {
+    // Too big for the inline storage, falls back to the heap
+    std::array<size_t, 16> values{};
+    values.fill(1);
+    size_t sum = 0;
+    task t([values, &sum] {
+        for (auto value : values) {
+            sum += value;
+        }
+    });
+
+    task assigned;
+    assigned = std::move(t);
+    assigned();
+    REQUIRE(sum == values.size());
+}
+
+TEST_CASE("task::DestroysCallable", "[task]") {
+    auto shared = std::make_shared<int>(0);
+    {
+        task t([shared] {});
+        REQUIRE(shared.use_count() == 2);
+
+        task moved(std::move(t));
+        REQUIRE(shared.use_count() == 2);
+
+        moved.reset();
+        REQUIRE(shared.use_count() == 1);
+    }
+    REQUIRE(shared.use_count() == 1);
+}
@@ -0,0 +1,148 @@
+#include "thread_pool/task_graph.h"
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace tp;
+
+namespace {
+
+/// Records the order nodes finish in
+struct Recorder {
+    explicit Recorder(const size_t nodes) : finished(nodes) {}
+
+    void finish(const size_t index) {
+        finished[index] = ++clock;
+    }
+
+    std::atomic<size_t> clock{0};
+    std::vector<std::atomic<size_t>> finished;
+};
+
+} // namespace
+
+TEST_CASE("task_graph::Empty", "[task_graph]") {
+    thread_pool tp({});
+    task_graph graph;
+    graph.run(tp);
+    REQUIRE(graph.size() == 0);
+}
+
+TEST_CASE("task_graph::Diamond", "[task_graph]") {
+    thread_pool tp({.size = 4});
+    Recorder recorder(4);
+
+    task_graph graph;
+    const auto top = graph.add([&recorder] { recorder.finish(0); });
+    const auto left = graph.add([&recorder] { recorder.finish(1); });
+    const auto right = graph.add([&recorder] { recorder.finish(2); });
+    const auto bottom = graph.add([&recorder] { recorder.finish(3); });
+    graph.depends_on(left, top);
+    graph.depends_on(right, top);
+    graph.depends_on(bottom, left);
+    graph.depends_on(bottom, right);
+
+    graph.run(tp);
+    REQUIRE(recorder.finished[top] < recorder.finished[left]);
+    REQUIRE(recorder.finished[top] < recorder.finished[right]);
+    REQUIRE(recorder.finished[left] < recorder.finished[bottom]);
+    REQUIRE(recorder.finished[right] < recorder.finished[bottom]);
+}
+
+TEST_CASE("task_graph::Layered", "[task_graph]") {
+    const auto scheduler = GENERATE(thread_pool::Scheduler::kGlobalQueue, thread_pool::Scheduler::kWorkStealing);
+    thread_pool tp({.size = 4, .scheduler = scheduler});
+
+    // Every node depends on a few nodes of the previous layer
+    constexpr size_t kLayers = 20;
+    constexpr size_t kWidth = 25;
+    Recorder recorder(kLayers * kWidth);
+    task_graph graph;
+    for (size_t ii = 0; ii < kLayers * kWidth; ii++) {
+        graph.add([&recorder, ii] { recorder.finish(ii); });
+    }
+    for (size_t layer = 1; layer < kLayers; layer++) {
+        for (size_t ii = 0; ii < kWidth; ii++) {
+            for (const auto offset : {0, 1, 7}) {
+                graph.depends_on(layer * kWidth + ii, (layer - 1) * kWidth + (ii + offset) % kWidth);
+            }
+        }
+    }
+
+    // Reusable, every run sees the same ordering
+    for (size_t run = 0; run < 5; run++) {
+        graph.run(tp);
+
+        size_t violations = 0;
+        for (size_t layer = 1; layer < kLayers; layer++) {
+            for (size_t ii = 0; ii < kWidth; ii++) {
+                for (const auto offset : {0, 1, 7}) {
+                    const auto predecessor = (layer - 1) * kWidth + (ii + offset) % kWidth;
+                    violations += recorder.finished[predecessor] > recorder.finished[layer * kWidth + ii];
+                }
+            }
+        }
+        REQUIRE(violations == 0);
+        REQUIRE(recorder.clock == (run + 1) * kLayers * kWidth);
+    }
+}
+
+TEST_CASE("task_graph::Exception", "[task_graph]") {
+    thread_pool tp({.size = 2});
+    std::atomic<bool> after_ran = false;
+
+    task_graph graph;
+    const auto failing = graph.add([] { throw std::runtime_error("failed"); });
+    const auto after = graph.add([&after_ran] { after_ran = true; });
+    graph.depends_on(after, failing);
+
+    REQUIRE_THROWS_AS(graph.run(tp), std::runtime_error);
+    REQUIRE(!after_ran);
+}
+
+TEST_CASE("task_graph::Cycle", "[task_graph]") {
+    thread_pool tp({});
+    task_graph graph;
+    const auto a = graph.add([] {});
+    const auto b = graph.add([] {});
+    graph.depends_on(b, a);
+    graph.depends_on(a, b);
+    REQUIRE_THROWS_AS(graph.run(tp), std::invalid_argument);
+    REQUIRE_THROWS_AS(graph.depends_on(a, 5), std::out_of_range);
+}
+
+TEST_CASE("task_graph::RunFromWorker", "[task_graph]") {
+    // The only worker runs the graph itself while it waits
+    thread_pool tp({.size = 1});
+    std::atomic<size_t> count = 0;
+
+    task_graph graph;
+    const auto first = graph.add([&count] { count++; });
+    for (size_t ii = 0; ii < 10; ii++) {
+        graph.depends_on(graph.add([&count] { count++; }), first);
+    }
+
+    tp.push([&graph, &tp] { graph.run(tp); }).get();
+    REQUIRE(count == 11);
+}
+
+TEST_CASE("task_graph::DestroyedAfterRun", "[task_graph]") {
+    // The last node may still be signalling when run() returns, the graph going away right after must be safe
+    thread_pool tp({.size = 4});
+    for (size_t run = 0; run < 200; run++) {
+        std::atomic<size_t> count = 0;
+        auto graph = std::make_unique<task_graph>();
+        const auto first = graph->add([&count] { count++; });
+        for (size_t ii = 0; ii < 8; ii++) {
+            graph->depends_on(graph->add([&count] { count++; }), first);
+        }
+
+        graph->run(tp);
+        graph.reset();
+        REQUIRE(count == 9);
+    }
+}
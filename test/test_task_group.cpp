@@ -0,0 +1,71 @@
+#include "thread_pool/task_group.h"
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+using namespace tp;
+
+namespace {
+
+/// Naive recursive fibonacci, every call spawns both halves and waits on them
+uint64_t fibonacci(thread_pool &tp, const uint64_t n) {
+    if (n < 2) {
+        return n;
+    }
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+    task_group group(tp);
+    group.spawn([&tp, &a, n] { a = fibonacci(tp, n - 1); });
+    group.spawn([&tp, &b, n] { b = fibonacci(tp, n - 2); });
+    group.wait();
+    return a + b;
+}
+
+} // namespace
+
+TEST_CASE("task_group::Wait", "[task_group]") {
+    thread_pool tp({.size = 4});
+    std::atomic<size_t> count = 0;
+
+    task_group group(tp);
+    for (size_t ii = 0; ii < 1000; ii++) {
+        group.spawn([&count] { count++; });
+    }
+    group.wait();
+    REQUIRE(count == 1000);
+
+    // Reusable once waited on
+    group.spawn([&count] { count++; });
+    group.wait();
+    REQUIRE(count == 1001);
+}
+
+TEST_CASE("task_group::Nested", "[task_group]") {
+    // Every worker ends up waiting on a group, which would deadlock if waiting blocked
+    const auto scheduler = GENERATE(thread_pool::Scheduler::kGlobalQueue, thread_pool::Scheduler::kWorkStealing);
+    const size_t size = GENERATE(1, 2);
+    thread_pool tp({.size = size, .scheduler = scheduler});
+
+    auto future = tp.push([&tp] { return fibonacci(tp, 18); });
+    REQUIRE(future.get() == 2584);
+}
+
+TEST_CASE("task_group::Exception", "[task_group]") {
+    thread_pool tp({.size = 2});
+    std::atomic<size_t> count = 0;
+
+    task_group group(tp);
+    group.spawn([] { throw std::runtime_error("first"); });
+    for (size_t ii = 0; ii < 10; ii++) {
+        group.spawn([&count] { count++; });
+    }
+
+    // Every task still runs, the exception surfaces once
+    REQUIRE_THROWS_AS(group.wait(), std::runtime_error);
+    REQUIRE(count == 10);
+    REQUIRE_NOTHROW(group.wait());
+}
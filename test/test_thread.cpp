@@ -3,6 +3,9 @@
 
 #include "catch.hpp"
 
+#include <sys/syscall.h>
+#include <unistd.h>
+
 using namespace tp;
 
 TEST_CASE("thread::DefaultConstructible", "[thread]") {
@@ -148,3 +151,19 @@ TEST_CASE("thread::IdAndHandle", "[thread]") {
     alive = false;
     t.join();
 }
+
+TEST_CASE("thread::IdLifetime", "[thread]") {
+    std::atomic<size_t> id_from_thread = 0;
+    thread t([&id_from_thread] { id_from_thread = static_cast<size_t>(syscall(__NR_gettid)); });
+
+    while (id_from_thread == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(t.get_id() == id_from_thread);
+
+    t.join();
+    REQUIRE_THROWS(t.get_id());
+
+    thread empty;
+    REQUIRE_THROWS(empty.get_id());
+}
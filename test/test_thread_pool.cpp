@@ -3,7 +3,19 @@
 
 #include "catch.hpp"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 using namespace tp;
 
@@ -114,6 +126,42 @@ TEST_CASE("thread_pool::RepeatedBursts", "[thread_pool]") {
     }
 }
 
+TEST_CASE("thread_pool::Post", "[thread_pool]") {
+    constexpr size_t kNumTasks = 1000;
+    constexpr size_t kPoolSize = 100;
+
+    thread_pool tp({.size = kPoolSize});
+
+    SECTION("Lambda") {
+        std::atomic<size_t> count = 0;
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            tp.post([&count] { lambda(count); });
+        }
+        tp.join(true);
+        REQUIRE(count == kNumTasks);
+    }
+
+    SECTION("Class") {
+        std::array<Class, kNumTasks> classes{};
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            tp.post(&Class::function, &classes[ii]);
+        }
+        tp.join(true);
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            REQUIRE(classes[ii].count == 1);
+        }
+    }
+}
+
+TEST_CASE("thread_pool::MoveOnlyCapture", "[thread_pool]") {
+    thread_pool tp({});
+
+    auto value = std::make_unique<size_t>(1);
+    auto future = tp.push([value = std::move(value)] { return *value; });
+
+    REQUIRE(future.get() == 1);
+}
+
 TEST_CASE("thread_pool::Future", "[thread_pool]") {
     std::atomic<bool> signal{false};
     auto wait_for_signal = [&signal] {
@@ -132,3 +180,868 @@ TEST_CASE("thread_pool::Future", "[thread_pool]") {
     REQUIRE(std::future_status::ready == future.wait_for(std::chrono::milliseconds(2)));
     future.get();
 }
+
+TEST_CASE("thread_pool::WorkStealing", "[thread_pool]") {
+    constexpr size_t kPoolSize = 8;
+    constexpr size_t kFanOut = 10;
+
+    thread_pool tp({.size = kPoolSize, .scheduler = thread_pool::Scheduler::kWorkStealing});
+
+    SECTION("ExternalPushes") {
+        std::atomic<size_t> count = 0;
+        for (size_t ii = 0; ii < kFanOut; ii++) {
+            tp.push([&count] { free_function(count); });
+        }
+        tp.join(true);
+        REQUIRE(count == kFanOut);
+    }
+
+    SECTION("NestedPushes") {
+        // Each outer task pushes more tasks from within a worker, which land on that worker's deque
+        std::atomic<size_t> count = 0;
+        for (size_t ii = 0; ii < kFanOut; ii++) {
+            tp.push([&tp, &count] {
+                for (size_t jj = 0; jj < kFanOut; jj++) {
+                    tp.push([&count] { count++; });
+                }
+            });
+        }
+
+        while (count != kFanOut * kFanOut) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        tp.join(true);
+        REQUIRE(tp.qsize() == 0);
+    }
+}
+
+TEST_CASE("thread_pool::LockFreeQueue", "[thread_pool]") {
+    constexpr size_t kNumTasks = 1000;
+    constexpr size_t kPoolSize = 8;
+
+    // Capacity smaller than the number of tasks so producers hit a full ring
+    thread_pool tp({.size = kPoolSize, .queue = thread_pool::Queue::kLockFree, .queue_capacity = 64});
+
+    std::atomic<size_t> count = 0;
+    for (size_t ii = 0; ii < kNumTasks; ii++) {
+        tp.push([&count] { count++; });
+    }
+    tp.join(true);
+    REQUIRE(count == kNumTasks);
+    REQUIRE(tp.qsize() == 0);
+}
+
+TEST_CASE("thread_pool::LockFreeQueueFullFromWorker", "[thread_pool]") {
+    constexpr size_t kNumTasks = 64;
+
+    // The only worker fills its own ring, nobody else can drain it
+    thread_pool tp({.size = 1, .queue = thread_pool::Queue::kLockFree, .queue_capacity = 8});
+    std::atomic<size_t> count = 0;
+
+    SECTION("Post") {
+        tp.push([&tp, &count] {
+            for (size_t ii = 0; ii < kNumTasks; ii++) {
+                tp.post([&count] { count++; });
+            }
+        }).get();
+    }
+
+    SECTION("PushN") {
+        tp.push([&tp, &count] {
+            tp.push_n(kNumTasks, [&count](size_t) { count++; });
+        }).get();
+    }
+
+    tp.join(true);
+    REQUIRE(count == kNumTasks);
+}
+
+TEST_CASE("thread_pool::TypedFuture", "[thread_pool]") {
+    thread_pool tp({.size = 4});
+
+    SECTION("Value") {
+        auto future = tp.push([](const int a, const int b) { return a + b; }, 1, 2);
+        static_assert(std::is_same_v<decltype(future), std::future<int>>);
+        REQUIRE(future.get() == 3);
+    }
+
+    SECTION("MemberFunction") {
+        struct Adder {
+            int base = 10;
+            int add(const int value) const { return base + value; }
+        } adder;
+
+        auto future = tp.push(&Adder::add, &adder, 5);
+        REQUIRE(future.get() == 15);
+    }
+
+    SECTION("MoveOnlyResult") {
+        auto future = tp.push([] { return std::make_unique<int>(7); });
+        REQUIRE(*future.get() == 7);
+    }
+
+    SECTION("Exception") {
+        auto future = tp.push([]() -> int { throw std::runtime_error("failed"); });
+        REQUIRE_THROWS_AS(future.get(), std::runtime_error);
+    }
+}
+
+TEST_CASE("thread_pool::Bulk", "[thread_pool]") {
+    constexpr size_t kNumTasks = 1000;
+    constexpr size_t kPoolSize = 8;
+
+    SECTION("PushBulk") {
+        thread_pool tp({.size = kPoolSize});
+
+        std::vector<std::function<size_t()>> callables;
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            callables.push_back([ii] { return ii * 2; });
+        }
+
+        auto futures = tp.push_bulk(callables.begin(), callables.end());
+        REQUIRE(futures.size() == kNumTasks);
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            REQUIRE(futures[ii].get() == ii * 2);
+        }
+    }
+
+    SECTION("PushN") {
+        thread_pool tp({.size = kPoolSize, .queue = thread_pool::Queue::kLockFree, .queue_capacity = 64});
+
+        std::vector<size_t> results(kNumTasks);
+        auto futures = tp.push_n(kNumTasks, [&results](const size_t ii) { results[ii] = ii; });
+        tp.join(true);
+
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            REQUIRE(results[ii] == ii);
+        }
+    }
+
+    SECTION("PushNFromWorker") {
+        thread_pool tp({.size = kPoolSize, .scheduler = thread_pool::Scheduler::kWorkStealing});
+
+        std::atomic<size_t> count = 0;
+        auto outer = tp.push([&tp, &count] {
+            return tp.push_n(kNumTasks, [&count](size_t) { count++; });
+        });
+
+        for (auto &future : outer.get()) {
+            future.get();
+        }
+        REQUIRE(count == kNumTasks);
+    }
+}
+
+TEST_CASE("thread_pool::BulkBenchmark", "[.][benchmark]") {
+    constexpr size_t kNumTasks = 100000;
+    constexpr size_t kPoolSize = 8;
+
+    auto time = [](auto &&submit) {
+        thread_pool tp({.size = kPoolSize});
+        const auto start = std::chrono::steady_clock::now();
+        submit(tp);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        tp.join(true);
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    };
+
+    const auto looped = time([](thread_pool &tp) {
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            tp.push([] {});
+        }
+    });
+    const auto bulk = time([](thread_pool &tp) {
+        tp.push_n(kNumTasks, [](size_t) {});
+    });
+
+    std::cout << "submit " << kNumTasks << " tasks, push loop (us): " << looped
+              << ", push_n (us): " << bulk << std::endl;
+}
+
+TEST_CASE("thread_pool::BatchDequeue", "[thread_pool]") {
+    constexpr size_t kNumTasks = 1000;
+    constexpr size_t kPoolSize = 4;
+    constexpr size_t kBatchSize = 16;
+
+    SECTION("GlobalQueue") {
+        thread_pool tp({.size = kPoolSize, .batch_size = kBatchSize});
+
+        std::atomic<size_t> count = 0;
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            tp.post([&count] { count++; });
+        }
+        tp.join(true);
+        REQUIRE(count == kNumTasks);
+        REQUIRE(tp.qsize() == 0);
+    }
+
+    SECTION("WorkStealing") {
+        thread_pool tp({.size = kPoolSize,
+                        .scheduler = thread_pool::Scheduler::kWorkStealing,
+                        .batch_size = kBatchSize});
+
+        std::atomic<size_t> count = 0;
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            tp.post([&count] { count++; });
+        }
+        tp.join(true);
+        REQUIRE(count == kNumTasks);
+    }
+
+    SECTION("Fairness") {
+        thread_pool tp({.size = kPoolSize, .batch_size = kBatchSize});
+
+        // Slow tasks, if one worker hoarded a batch the others would sit idle
+        std::mutex lock;
+        std::set<std::thread::id> ids;
+        for (size_t ii = 0; ii < kBatchSize; ii++) {
+            tp.post([&lock, &ids] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                std::scoped_lock guard(lock);
+                ids.insert(std::this_thread::get_id());
+            });
+        }
+        tp.join(true);
+        REQUIRE(ids.size() > 1);
+    }
+}
+
+TEST_CASE("thread_pool::WaitPolicy", "[thread_pool]") {
+    constexpr size_t kNumTasks = 100;
+    constexpr size_t kPoolSize = 4;
+
+    auto run = [](const thread_pool::Params &params) {
+        thread_pool tp(params);
+
+        // Sparse arrivals so workers go idle between tasks
+        std::atomic<size_t> count = 0;
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            tp.push([&count] { count++; }).get();
+        }
+        tp.join(true);
+        return count.load();
+    };
+
+    SECTION("Spin") {
+        REQUIRE(kNumTasks == run({.size = kPoolSize, .wait_policy = thread_pool::WaitPolicy::kSpin, .spin_count = 100}));
+    }
+
+    SECTION("SpinYield") {
+        REQUIRE(kNumTasks == run({.size = kPoolSize, .wait_policy = thread_pool::WaitPolicy::kSpinYield, .spin_count = 100}));
+    }
+
+    SECTION("Adaptive") {
+        REQUIRE(kNumTasks == run({.size = kPoolSize,
+                                  .wait_policy = thread_pool::WaitPolicy::kSpinYield,
+                                  .spin_count = 100,
+                                  .adaptive_threshold = std::chrono::microseconds(50)}));
+    }
+}
+
+TEST_CASE("thread_pool::WaitPolicyBenchmark", "[.][benchmark]") {
+    constexpr size_t kNumTasks = 10000;
+    constexpr size_t kPoolSize = 4;
+
+    // p99 of the time between push and the task starting
+    auto p99 = [](const thread_pool::Params &params) {
+        thread_pool tp(params);
+        std::vector<std::chrono::nanoseconds> latencies;
+        latencies.reserve(kNumTasks);
+
+        for (size_t ii = 0; ii < kNumTasks; ii++) {
+            const auto start = std::chrono::steady_clock::now();
+            auto future = tp.push([start] { return std::chrono::steady_clock::now() - start; });
+            latencies.push_back(future.get());
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        return std::chrono::duration_cast<std::chrono::microseconds>(latencies[kNumTasks * 99 / 100]).count();
+    };
+
+    std::cout << "p99 dispatch latency (us)"
+              << ", block: " << p99({.size = kPoolSize})
+              << ", spin: " << p99({.size = kPoolSize, .wait_policy = thread_pool::WaitPolicy::kSpin})
+              << ", spin yield: " << p99({.size = kPoolSize, .wait_policy = thread_pool::WaitPolicy::kSpinYield})
+              << ", adaptive: " << p99({.size = kPoolSize,
+                                        .wait_policy = thread_pool::WaitPolicy::kSpinYield,
+                                        .adaptive_threshold = std::chrono::microseconds(100)})
+              << std::endl;
+}
+
+TEST_CASE("thread_pool::Priority", "[thread_pool]") {
+    constexpr size_t kNumBackground = 1000;
+    constexpr size_t kPoolSize = 2;
+    constexpr auto kLow = priority{1};
+    constexpr auto kHigh = priority{0};
+
+    auto background = [] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); };
+
+    // How long a high priority task waits behind a saturated low priority lane
+    auto latency = [&background](const thread_pool::Params &params) {
+        thread_pool tp(params);
+        for (size_t ii = 0; ii < kNumBackground; ii++) {
+            tp.push(kLow, background);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        tp.push(kHigh, [] {}).get();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        tp.join(false);
+        return elapsed;
+    };
+
+    SECTION("Strict") {
+        const auto elapsed = latency({.size = kPoolSize, .priority_levels = 2});
+        REQUIRE(elapsed < std::chrono::milliseconds(100));
+    }
+
+    SECTION("Weighted") {
+        const auto elapsed = latency({.size = kPoolSize,
+                                      .priority_levels = 2,
+                                      .dispatch = thread_pool::Dispatch::kWeighted,
+                                      .priority_weights = {4, 1}});
+        REQUIRE(elapsed < std::chrono::milliseconds(100));
+    }
+
+    SECTION("LockFree") {
+        const auto elapsed = latency({.size = kPoolSize,
+                                      .queue = thread_pool::Queue::kLockFree,
+                                      .queue_capacity = kNumBackground,
+                                      .priority_levels = 2});
+        REQUIRE(elapsed < std::chrono::milliseconds(100));
+    }
+
+    SECTION("WeightedDoesNotStarve") {
+        // With one worker busy on high priority work, low priority tasks still make progress
+        thread_pool tp({.size = 1,
+                        .priority_levels = 2,
+                        .dispatch = thread_pool::Dispatch::kWeighted,
+                        .priority_weights = {3, 1}});
+
+        std::atomic<size_t> high_ran = 0;
+        std::atomic<size_t> high_ran_before_low = 0;
+        for (size_t ii = 0; ii < 100; ii++) {
+            tp.push(kHigh, [&high_ran] { high_ran++; });
+        }
+        tp.push(kLow, [&high_ran, &high_ran_before_low] { high_ran_before_low = high_ran.load(); });
+        for (size_t ii = 0; ii < 100; ii++) {
+            tp.push(kHigh, [&high_ran] { high_ran++; });
+        }
+
+        tp.join(true);
+        REQUIRE(high_ran == 200);
+        REQUIRE(high_ran_before_low < 200);
+    }
+
+    SECTION("OutOfRangeLevel") {
+        thread_pool tp({.size = kPoolSize, .priority_levels = 2});
+        REQUIRE(tp.push(priority{10}, [] { return 1; }).get() == 1);
+    }
+}
+
+TEST_CASE("thread_pool::Deadline", "[thread_pool]") {
+    using clock = thread_pool::clock;
+
+    SECTION("Expired") {
+        thread_pool tp({});
+        std::atomic<bool> ran = false;
+        auto future = tp.push(clock::now() - std::chrono::milliseconds(1), [&ran] { ran = true; });
+        REQUIRE_THROWS_AS(future.get(), deadline_expired);
+        REQUIRE(!ran);
+    }
+
+    SECTION("InTime") {
+        thread_pool tp({});
+        auto future = tp.push(clock::now() + std::chrono::seconds(10), [] { return 1; });
+        REQUIRE(future.get() == 1);
+    }
+
+    SECTION("EarliestDeadlineFirst") {
+        thread_pool tp({.size = 1, .earliest_deadline_first = true});
+
+        // Hold the only worker so everything below queues up
+        std::promise<void> gate;
+        auto blocker = tp.push([opened = gate.get_future()]() mutable { opened.wait(); });
+
+        std::mutex lock;
+        std::vector<size_t> order;
+        auto record = [&lock, &order](const size_t id) {
+            std::scoped_lock guard(lock);
+            order.push_back(id);
+        };
+
+        const auto now = clock::now();
+        tp.push(record, 0);
+        tp.push(now + std::chrono::seconds(30), record, 3);
+        tp.push(now + std::chrono::seconds(10), record, 1);
+        tp.push(now + std::chrono::seconds(20), record, 2);
+
+        gate.set_value();
+        tp.join(true);
+
+        // Deadline tasks first by deadline, then the rest
+        REQUIRE(order == std::vector<size_t>{1, 2, 3, 0});
+    }
+}
+
+TEST_CASE("thread_pool::Schedule", "[thread_pool]") {
+    using clock = thread_pool::clock;
+    constexpr auto kDelay = std::chrono::milliseconds(20);
+
+    SECTION("After") {
+        thread_pool tp({});
+        std::promise<clock::time_point> ran;
+        const auto start = clock::now();
+        tp.schedule_after(kDelay, [&ran] { ran.set_value(clock::now()); });
+        REQUIRE(ran.get_future().get() - start >= kDelay);
+    }
+
+    SECTION("At") {
+        thread_pool tp({});
+        std::promise<clock::time_point> ran;
+        const auto when = clock::now() + kDelay;
+        tp.schedule_at(when, [&ran] { ran.set_value(clock::now()); });
+        REQUIRE(ran.get_future().get() >= when);
+    }
+
+    SECTION("Every") {
+        thread_pool tp({.size = 2});
+        std::atomic<size_t> runs = 0;
+        std::promise<void> done;
+        const auto handle = tp.schedule_every(std::chrono::milliseconds(2), [&runs, &done] {
+            if (++runs == 5) {
+                done.set_value();
+            }
+        });
+
+        done.get_future().wait();
+        REQUIRE(tp.cancel(handle));
+        REQUIRE(!tp.cancel(handle));
+    }
+
+    SECTION("EverySlowerThanPeriod") {
+        std::atomic<size_t> running = 0;
+        std::atomic<size_t> overlaps = 0;
+        std::atomic<size_t> runs = 0;
+        std::promise<void> done;
+
+        // Every run takes several periods, with free workers to overlap on if the timer let it
+        thread_pool tp({.size = 4});
+        const auto handle = tp.schedule_every(std::chrono::milliseconds(1), [&] {
+            overlaps += (++running > 1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            running--;
+            if (++runs == 5) {
+                done.set_value();
+            }
+        });
+
+        done.get_future().wait();
+        REQUIRE(tp.cancel(handle));
+        REQUIRE(overlaps == 0);
+    }
+
+    SECTION("AfterIdleGap") {
+        // At 1ns per tick an idle gap is hundreds of millions of ticks, stepping through them would take seconds
+        constexpr auto kGap = std::chrono::milliseconds(200);
+        thread_pool tp({.timer_resolution = std::chrono::nanoseconds(1)});
+        std::promise<void> first;
+        tp.schedule_after(clock::duration::zero(), [&first] { first.set_value(); });
+        first.get_future().wait();
+
+        std::this_thread::sleep_for(kGap);
+        std::promise<void> second;
+        const auto start = clock::now();
+        tp.schedule_after(clock::duration::zero(), [&second] { second.set_value(); });
+        second.get_future().wait();
+        REQUIRE(clock::now() - start < kGap);
+    }
+
+    SECTION("Cancel") {
+        thread_pool tp({});
+        std::atomic<bool> cancelled_ran = false;
+        std::promise<void> ran;
+        const auto cancelled = tp.schedule_after(kDelay, [&cancelled_ran] { cancelled_ran = true; });
+        tp.schedule_after(kDelay * 2, [&ran] { ran.set_value(); });
+        REQUIRE(tp.cancel(cancelled));
+
+        ran.get_future().wait();
+        REQUIRE(!cancelled_ran);
+    }
+
+    SECTION("DroppedOnJoin") {
+        std::atomic<bool> ran = false;
+        {
+            thread_pool tp({});
+            tp.schedule_after(std::chrono::seconds(10), [&ran] { ran = true; });
+        }
+        REQUIRE(!ran);
+    }
+}
+
+TEST_CASE("thread_pool::Cancellation", "[thread_pool]") {
+    SECTION("Token") {
+        cancellation_token never;
+        REQUIRE(!never.cancelled());
+        REQUIRE_NOTHROW(never.throw_if_cancelled());
+
+        cancellation_source source;
+        const auto token = source.token();
+        REQUIRE(!token.cancelled());
+        source.cancel();
+        REQUIRE(source.cancelled());
+        REQUIRE(token.cancelled());
+        REQUIRE_THROWS_AS(token.throw_if_cancelled(), task_cancelled);
+    }
+
+    SECTION("Queued") {
+        thread_pool tp({.size = 1});
+
+        // Hold the only worker so everything below queues up
+        std::promise<void> gate;
+        auto blocker = tp.push([opened = gate.get_future()]() mutable { opened.wait(); });
+
+        cancellation_source source;
+        std::atomic<size_t> ran = 0;
+        std::vector<std::future<void>> cancelled;
+        for (size_t ii = 0; ii < 10; ii++) {
+            cancelled.push_back(tp.push(source.token(), [&ran] { ran++; }));
+        }
+        auto kept = tp.push(cancellation_source().token(), [] { return 1; });
+
+        source.cancel();
+        gate.set_value();
+
+        for (auto &future : cancelled) {
+            REQUIRE_THROWS_AS(future.get(), task_cancelled);
+        }
+        REQUIRE(kept.get() == 1);
+        REQUIRE(ran == 0);
+    }
+
+    SECTION("Running") {
+        thread_pool tp({});
+        cancellation_source source;
+        std::promise<void> started;
+        auto future = tp.push(source.token(), [&started](const cancellation_token token) {
+            started.set_value();
+            size_t polls = 0;
+            while (!token.cancelled()) {
+                polls++;
+            }
+            return polls;
+        }, source.token());
+
+        started.get_future().wait();
+        source.cancel();
+        REQUIRE_NOTHROW(future.get());
+    }
+}
+
+TEST_CASE("thread_pool::BoundedQueue", "[thread_pool]") {
+    constexpr size_t kMaxQueueSize = 2;
+    const auto queue = GENERATE(thread_pool::Queue::kMutex, thread_pool::Queue::kLockFree);
+    auto params = [queue](const thread_pool::Overflow overflow, const size_t max_queue_size) {
+        return thread_pool::Params{.size = 1, .queue = queue, .max_queue_size = max_queue_size, .overflow = overflow};
+    };
+
+    // Holds the only worker until the gate opens, so everything pushed afterwards stays queued
+    std::promise<void> gate;
+    std::promise<void> started;
+    auto hold = [&gate, &started](thread_pool &tp) {
+        auto blocker = tp.push([&started, opened = gate.get_future()]() mutable {
+            started.set_value();
+            opened.wait();
+        });
+        started.get_future().wait();
+        return blocker;
+    };
+
+    SECTION("Reject") {
+        thread_pool tp(params(thread_pool::Overflow::kReject, kMaxQueueSize));
+        auto blocker = hold(tp);
+
+        auto first = tp.push([] { return 1; });
+        auto second = tp.try_push([] { return 2; });
+        REQUIRE(second.has_value());
+        REQUIRE(tp.qsize() == kMaxQueueSize);
+
+        auto rejected = tp.push([] { return 3; });
+        REQUIRE(!tp.try_push([] { return 4; }).has_value());
+        REQUIRE_THROWS_AS(rejected.get(), queue_full);
+        REQUIRE(tp.qsize() == kMaxQueueSize);
+
+        // post() and the bulk pushes are bounded too
+        std::atomic<bool> posted_ran = false;
+        REQUIRE(!tp.post([&posted_ran] { posted_ran = true; }));
+        auto bulk = tp.push_n(2, [](const size_t) {});
+        REQUIRE_THROWS_AS(bulk[0].get(), queue_full);
+        REQUIRE_THROWS_AS(bulk[1].get(), queue_full);
+        REQUIRE(tp.qsize() == kMaxQueueSize);
+
+        gate.set_value();
+        REQUIRE(first.get() == 1);
+        REQUIRE(second->get() == 2);
+        tp.push([] {}).get();
+        REQUIRE(!posted_ran);
+    }
+
+    SECTION("DropOldest") {
+        thread_pool tp(params(thread_pool::Overflow::kDropOldest, kMaxQueueSize));
+        auto blocker = hold(tp);
+
+        auto first = tp.push([] { return 1; });
+        auto second = tp.push([] { return 2; });
+        auto third = tp.push([] { return 3; });
+        REQUIRE(tp.qsize() == kMaxQueueSize);
+
+        gate.set_value();
+        REQUIRE(second.get() == 2);
+        if (queue == thread_pool::Queue::kMutex) {
+            REQUIRE_THROWS_AS(first.get(), std::future_error);
+            REQUIRE(third.get() == 3);
+        } else {
+            // The ring cannot tell a continuation from a pushed task, so it rejects instead
+            REQUIRE(first.get() == 1);
+            REQUIRE_THROWS_AS(third.get(), queue_full);
+        }
+    }
+
+    SECTION("CallerRuns") {
+        thread_pool tp(params(thread_pool::Overflow::kCallerRuns, kMaxQueueSize));
+        auto blocker = hold(tp);
+
+        tp.push([] {});
+        tp.push([] {});
+        auto inline_run = tp.push([] { return std::this_thread::get_id(); });
+        REQUIRE(inline_run.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        REQUIRE(inline_run.get() == std::this_thread::get_id());
+
+        gate.set_value();
+    }
+
+    SECTION("Block") {
+        thread_pool tp(params(thread_pool::Overflow::kBlock, kMaxQueueSize));
+        auto blocker = hold(tp);
+
+        tp.push([] {});
+        tp.push([] {});
+
+        // The producer waits until the worker frees a slot
+        std::atomic<bool> pushed = false;
+        std::thread producer([&tp, &pushed] {
+            tp.push([] {}).wait();
+            pushed = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        REQUIRE(!pushed);
+        REQUIRE(tp.qsize() == kMaxQueueSize);
+
+        gate.set_value();
+        producer.join();
+        REQUIRE(pushed);
+    }
+
+    SECTION("BlockFromWorker") {
+        thread_pool tp(params(thread_pool::Overflow::kBlock, 1));
+
+        // Blocking the only worker on its own full queue would never finish, so it runs the task itself
+        auto outer = tp.push([&tp] {
+            tp.push([] {});
+            return tp.push([] { return std::this_thread::get_id(); }).get();
+        });
+        REQUIRE(outer.get() != std::this_thread::get_id());
+    }
+
+    SECTION("BlockFromWorkerDepth") {
+        constexpr size_t kMaxInlineDepth = 4;
+        constexpr size_t kTasks = 64;
+        thread_pool tp({.size = 1,
+                        .queue = queue,
+                        .max_queue_size = 1,
+                        .overflow = thread_pool::Overflow::kBlock,
+                        .max_inline_depth = kMaxInlineDepth});
+
+        // Every task fills the queue and then posts the next one, which would nest without limit if run inline
+        std::atomic<size_t> depth = 0;
+        std::atomic<size_t> max_depth = 0;
+        std::atomic<size_t> ran = 0;
+        std::promise<void> done;
+        std::function<void()> step = [&] {
+            const auto current = ++depth;
+            max_depth = std::max<size_t>(max_depth, current);
+            if (++ran < kTasks) {
+                tp.post([] {});
+                tp.post(step);
+            } else {
+                done.set_value();
+            }
+            depth--;
+        };
+
+        tp.post(step);
+        done.get_future().wait();
+        REQUIRE(max_depth <= kMaxInlineDepth + 1);
+    }
+}
+
+TEST_CASE("thread_pool::Inline", "[thread_pool]") {
+    const auto caller = std::this_thread::get_id();
+    auto where = [] { return std::this_thread::get_id(); };
+
+    SECTION("QueueDepth") {
+        thread_pool tp({.size = 1, .inline_queue_depth = 2});
+
+        // Hold the only worker so pushes below queue up
+        std::promise<void> gate;
+        std::promise<void> started;
+        auto blocker = tp.push([&started, opened = gate.get_future()]() mutable {
+            started.set_value();
+            opened.wait();
+        });
+        started.get_future().wait();
+
+        auto first = tp.push(where);
+        auto second = tp.push(where);
+        auto third = tp.push(where);
+        REQUIRE(tp.qsize() == 2);
+        REQUIRE(third.get() == caller);
+
+        gate.set_value();
+        REQUIRE(first.get() != caller);
+        REQUIRE(second.get() != caller);
+    }
+
+    SECTION("EstimatedWait") {
+        thread_pool tp({.size = 1, .inline_wait = std::chrono::milliseconds(1)});
+
+        // Nothing measured yet, so nothing is expected to wait
+        std::promise<void> gate;
+        std::promise<void> started;
+        auto blocker = tp.push([&started, opened = gate.get_future()]() mutable {
+            started.set_value();
+            opened.wait();
+        });
+        started.get_future().wait();
+        auto queued = tp.push(where);
+        REQUIRE(tp.qsize() == 1);
+        gate.set_value();
+        REQUIRE(queued.get() != caller);
+
+        // Slow tasks teach the pool that one queued task means a wait of a few milliseconds
+        for (size_t ii = 0; ii < 4; ii++) {
+            tp.push([] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }).wait();
+        }
+
+        std::promise<void> second_gate;
+        std::promise<void> second_started;
+        blocker = tp.push([&second_started, opened = second_gate.get_future()]() mutable {
+            second_started.set_value();
+            opened.wait();
+        });
+        second_started.get_future().wait();
+
+        auto first = tp.push(where);
+        auto second = tp.push(where);
+        REQUIRE(second.get() == caller);
+
+        second_gate.set_value();
+        REQUIRE(first.get() != caller);
+    }
+
+    SECTION("FromWorker") {
+        constexpr size_t kMaxDepth = 3;
+        thread_pool tp({.size = 2, .inline_from_worker = true, .max_inline_depth = kMaxDepth});
+
+        // Each level pushes the next and waits for it, levels past the limit go back to the queue
+        std::vector<std::thread::id> threads(kMaxDepth + 2);
+        std::function<void(size_t)> nest = [&](const size_t level) {
+            threads[level] = std::this_thread::get_id();
+            if (level + 1 < threads.size()) {
+                tp.push(nest, level + 1).get();
+            }
+        };
+        tp.push(nest, 0).get();
+
+        for (size_t level = 1; level <= kMaxDepth; level++) {
+            REQUIRE(threads[level] == threads[0]);
+        }
+        REQUIRE(threads[kMaxDepth + 1] != threads[0]);
+    }
+}
+
+TEST_CASE("thread_pool::Elastic", "[thread_pool]") {
+    const auto scheduler = GENERATE(thread_pool::Scheduler::kGlobalQueue, thread_pool::Scheduler::kWorkStealing);
+
+    // Polls until the condition holds or a generous timeout passes
+    auto eventually = [](auto &&condition) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return condition();
+    };
+
+    SECTION("Fixed") {
+        thread_pool tp({.size = 2, .scheduler = scheduler});
+        REQUIRE(tp.size() == 2);
+    }
+
+    SECTION("GrowAndShrink") {
+        constexpr size_t kMaxSize = 4;
+        thread_pool tp({.size = 1,
+                        .scheduler = scheduler,
+                        .max_size = kMaxSize,
+                        .grow_threshold = std::chrono::milliseconds(1),
+                        .keep_alive = std::chrono::milliseconds(20),
+                        .resize_cooldown = std::chrono::milliseconds(1)});
+        REQUIRE(tp.size() == 1);
+
+        // Tasks that block until the gate opens keep every worker busy, so the queue keeps waiting
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        std::atomic<size_t> running = 0;
+        std::atomic<size_t> most_running = 0;
+        std::vector<std::future<void>> futures;
+        for (size_t ii = 0; ii < kMaxSize * 2; ii++) {
+            futures.push_back(tp.push([&running, &most_running, opened] {
+                const auto now = ++running;
+                auto seen = most_running.load();
+                while (now > seen && !most_running.compare_exchange_weak(seen, now)) {
+                }
+                opened.wait();
+                running--;
+            }));
+        }
+
+        REQUIRE(eventually([&] { return tp.size() == kMaxSize; }));
+        REQUIRE(eventually([&] { return most_running == kMaxSize; }));
+
+        gate.set_value();
+        for (auto &future : futures) {
+            future.get();
+        }
+        REQUIRE(most_running == kMaxSize);
+
+        // Idle workers above the minimum retire, but never the minimum itself
+        REQUIRE(eventually([&] { return tp.size() == 1; }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE(tp.size() == 1);
+
+        // Retired workers can be replaced
+        REQUIRE(tp.push([] { return 1; }).get() == 1);
+    }
+
+    SECTION("StartsEmpty") {
+        thread_pool tp({.size = 0,
+                        .scheduler = scheduler,
+                        .max_size = 2,
+                        .grow_threshold = std::chrono::milliseconds(1),
+                        .resize_cooldown = std::chrono::milliseconds(1)});
+        REQUIRE(tp.size() == 0);
+        REQUIRE(tp.push([] { return 1; }).get() == 1);
+        REQUIRE(tp.size() >= 1);
+    }
+}
@@ -0,0 +1,111 @@
+#include "thread_pool/timer_wheel.h"
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+using namespace tp;
+
+namespace {
+
+/// Advances one tick at a time and records the tick each payload expired on
+std::vector<std::pair<uint64_t, uint64_t>> run(timer_wheel<uint64_t> &wheel, const uint64_t until) {
+    std::vector<std::pair<uint64_t, uint64_t>> expired;
+    while (wheel.now() < until && !wheel.empty()) {
+        wheel.advance(wheel.now() + 1, [&wheel, &expired](uint64_t &payload) -> std::optional<uint64_t> {
+            expired.emplace_back(wheel.now(), payload);
+            return std::nullopt;
+        });
+    }
+    return expired;
+}
+
+} // namespace
+
+TEST_CASE("timer_wheel::Empty", "[timer_wheel]") {
+    timer_wheel<uint64_t> wheel;
+    REQUIRE(wheel.empty());
+    REQUIRE(!wheel.cancel(timer_handle{}));
+
+    // Nothing to do, jumps straight to the tick
+    wheel.advance(1000, [](uint64_t &) -> std::optional<uint64_t> { return std::nullopt; });
+    REQUIRE(wheel.now() == 1000);
+}
+
+TEST_CASE("timer_wheel::ExpiresOnTime", "[timer_wheel]") {
+    // Spread across every level, including wheel boundaries
+    const std::vector<uint64_t> expiries{
+        1, 2, 255, 256, 257, 300, 511, 512, 65535, 65536, 65537, 70000, (1ULL << 24) - 1, (1ULL << 24) + 5,
+    };
+
+    timer_wheel<uint64_t> wheel;
+    for (const auto expiry : expiries) {
+        wheel.insert(expiry, expiry);
+    }
+    REQUIRE(wheel.size() == expiries.size());
+
+    const auto expired = run(wheel, UINT64_MAX);
+    REQUIRE(expired.size() == expiries.size());
+    for (size_t ii = 0; ii < expiries.size(); ii++) {
+        REQUIRE(expired[ii].first == expiries[ii]);
+        REQUIRE(expired[ii].second == expiries[ii]);
+    }
+    REQUIRE(wheel.empty());
+}
+
+TEST_CASE("timer_wheel::InsertWhileRunning", "[timer_wheel]") {
+    timer_wheel<uint64_t> wheel;
+    wheel.insert(1000, 0);
+    run(wheel, 300);
+    REQUIRE(wheel.now() == 300);
+
+    // Relative to the current tick, which is not aligned to any level
+    wheel.insert(300 + 256, 1);
+    wheel.insert(300 + 65536, 2);
+    wheel.insert(0, 3);
+
+    const auto expired = run(wheel, UINT64_MAX);
+    REQUIRE(expired == std::vector<std::pair<uint64_t, uint64_t>>{{301, 3}, {556, 1}, {1000, 0}, {65836, 2}});
+}
+
+TEST_CASE("timer_wheel::Cancel", "[timer_wheel]") {
+    timer_wheel<uint64_t> wheel;
+    const auto first = wheel.insert(10, 1);
+    const auto second = wheel.insert(10, 2);
+    wheel.insert(10, 3);
+
+    REQUIRE(wheel.cancel(second));
+    REQUIRE(!wheel.cancel(second));
+    REQUIRE(wheel.size() == 2);
+
+    const auto expired = run(wheel, UINT64_MAX);
+    REQUIRE(expired.size() == 2);
+    REQUIRE(!wheel.cancel(first));
+
+    // A recycled slot does not honour stale handles
+    const auto recycled = wheel.insert(20, 4);
+    REQUIRE(recycled.index == first.index);
+    REQUIRE(!wheel.cancel(first));
+    REQUIRE(wheel.cancel(recycled));
+}
+
+TEST_CASE("timer_wheel::Rearm", "[timer_wheel]") {
+    timer_wheel<uint64_t> wheel;
+    const auto handle = wheel.insert(100, 0);
+
+    std::vector<uint64_t> ticks;
+    while (ticks.size() < 5) {
+        wheel.advance(wheel.now() + 1, [&wheel, &ticks](uint64_t &) -> std::optional<uint64_t> {
+            ticks.push_back(wheel.now());
+            return wheel.now() + 100;
+        });
+    }
+    REQUIRE(ticks == std::vector<uint64_t>{100, 200, 300, 400, 500});
+
+    // Same handle across runs
+    REQUIRE(wheel.cancel(handle));
+    REQUIRE(wheel.empty());
+}
@@ -0,0 +1,96 @@
+#include "thread_pool/thread.h"
+#include "thread_pool/work_stealing_deque.h"
+
+#include "catch.hpp"
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+using namespace tp;
+
+TEST_CASE("work_stealing_deque::Empty", "[work_stealing_deque]") {
+    work_stealing_deque<int *> deque;
+    REQUIRE(deque.empty());
+    REQUIRE(deque.pop() == nullptr);
+    REQUIRE(deque.steal() == nullptr);
+}
+
+TEST_CASE("work_stealing_deque::Order", "[work_stealing_deque]") {
+    std::array<int, 3> values{0, 1, 2};
+    work_stealing_deque<int *> deque;
+    for (auto &value : values) {
+        deque.push(&value);
+    }
+    REQUIRE(deque.size() == values.size());
+
+    SECTION("PopIsLifo") {
+        REQUIRE(deque.pop() == &values[2]);
+        REQUIRE(deque.pop() == &values[1]);
+        REQUIRE(deque.pop() == &values[0]);
+        REQUIRE(deque.pop() == nullptr);
+    }
+
+    SECTION("StealIsFifo") {
+        REQUIRE(deque.steal() == &values[0]);
+        REQUIRE(deque.steal() == &values[1]);
+        REQUIRE(deque.steal() == &values[2]);
+        REQUIRE(deque.steal() == nullptr);
+    }
+}
+
+TEST_CASE("work_stealing_deque::Grow", "[work_stealing_deque]") {
+    constexpr size_t kNumElements = 1000;
+    std::vector<size_t> values(kNumElements);
+
+    work_stealing_deque<size_t *> deque(2);
+    for (auto &value : values) {
+        deque.push(&value);
+    }
+    REQUIRE(deque.size() == kNumElements);
+
+    for (size_t ii = 0; ii < kNumElements; ii++) {
+        REQUIRE(deque.pop() == &values[kNumElements - ii - 1]);
+    }
+}
+
+TEST_CASE("work_stealing_deque::ConcurrentSteal", "[work_stealing_deque]") {
+    constexpr size_t kNumElements = 100000;
+    constexpr size_t kNumThieves = 4;
+    std::vector<std::atomic<size_t>> taken(kNumElements);
+    std::vector<size_t> values(kNumElements);
+    work_stealing_deque<size_t *> deque;
+
+    std::atomic<bool> done{false};
+    auto thief = [&] {
+        while (!done || !deque.empty()) {
+            if (auto *value = deque.steal()) {
+                taken[static_cast<size_t>(value - values.data())]++;
+            }
+        }
+    };
+
+    std::vector<thread> thieves;
+    for (size_t ii = 0; ii < kNumThieves; ii++) {
+        thieves.push_back(thread(thief));
+    }
+
+    // Owner interleaves pushes and pops while thieves steal
+    for (size_t ii = 0; ii < kNumElements; ii++) {
+        deque.push(&values[ii]);
+        if (ii % 3 == 0) {
+            if (auto *value = deque.pop()) {
+                taken[static_cast<size_t>(value - values.data())]++;
+            }
+        }
+    }
+    done = true;
+
+    for (auto &t : thieves) {
+        t.join();
+    }
+
+    for (auto &count : taken) {
+        REQUIRE(count == 1);
+    }
+}